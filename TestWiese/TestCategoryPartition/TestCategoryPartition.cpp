@@ -0,0 +1,125 @@
+// from STL
+#include <string>
+#include <vector>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/CategoryPartition.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Sum of varMass over all entries of a dataset
+ */
+double SumMass(const RooAbsData& data) {
+  double sum = 0.0;
+  for (int i=0; i<data.numEntries(); ++i) {
+    sum += data.get(i)->getRealValue("varMass");
+  }
+  return sum;
+}
+
+/**
+ *  @brief Compare a partition with RooAbsData::reduce() on the same states
+ *
+ *  @return 0 if view and dataset agree with the reduced dataset, 1 otherwise
+ */
+int CheckPartition(const doocore::io::CategoryPartition& partition, const std::vector<RooDataSet*>& datasets,
+                   RooDataSet& data, const std::string& label, const std::string& cut) {
+  using namespace doocore::io;
+  RooAbsData* reference = data.reduce(cut.c_str());
+  int         num_reference = reference->numEntries();
+  double      sum_reference = SumMass(*reference);
+  delete reference;
+
+  int p = partition.Find(label);
+  if (p < 0) {
+    if (num_reference == 0) return 0;
+    serr << label << ": Partition missing for " << num_reference << " entries." << endmsg;
+    return 1;
+  }
+
+  double sum_view = 0.0;
+  for (std::size_t i=0; i<partition.size(p); ++i) {
+    if (i > 0 && partition.indices(p)[i] <= partition.indices(p)[i-1]) {
+      serr << label << ": Entry indices not ascending." << endmsg;
+      return 1;
+    }
+    sum_view += partition.Get(p, i)->getRealValue("varMass");
+  }
+
+  if (static_cast<int>(partition.size(p)) != num_reference || sum_view != sum_reference) {
+    serr << label << ": View with " << partition.size(p) << " entries (sum " << sum_view << ") vs. " 
+         << num_reference << " entries (sum " << sum_reference << ") from reduce()." << endmsg;
+    return 1;
+  }
+  if (datasets[p]->numEntries() != num_reference || SumMass(*datasets[p]) != sum_reference) {
+    serr << label << ": Dataset with " << datasets[p]->numEntries() << " entries (sum " << SumMass(*datasets[p]) 
+         << ") vs. " << num_reference << " entries (sum " << sum_reference << ") from reduce()." << endmsg;
+    return 1;
+  }
+  sinfo << label << ": " << num_reference << " entries as with reduce()." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+  RooCategory pol("pol", "pol");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+  pol.defineType("up", 1);
+  pol.defineType("down", -1);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat, pol), 10000);
+
+  int num_failed = 0;
+
+  CategoryPartition partition_single(*data_gen, RooArgSet(cat));
+  std::vector<RooDataSet*> datasets_single = partition_single.CreateDataSets();
+  num_failed += CheckPartition(partition_single, datasets_single, *data_gen, "bla", "cat==1");
+  num_failed += CheckPartition(partition_single, datasets_single, *data_gen, "blub", "cat==0");
+
+  CategoryPartition partition_combined(*data_gen, RooArgSet(cat, pol));
+  std::vector<RooDataSet*> datasets_combined = partition_combined.CreateDataSets();
+  num_failed += CheckPartition(partition_combined, datasets_combined, *data_gen, "{bla;up}", "cat==1&&pol==1");
+  num_failed += CheckPartition(partition_combined, datasets_combined, *data_gen, "{bla;down}", "cat==1&&pol==-1");
+  num_failed += CheckPartition(partition_combined, datasets_combined, *data_gen, "{blub;up}", "cat==0&&pol==1");
+  num_failed += CheckPartition(partition_combined, datasets_combined, *data_gen, "{blub;down}", "cat==0&&pol==-1");
+
+  std::size_t num_entries = 0;
+  for (std::size_t p=0; p<partition_combined.num_partitions(); ++p) {
+    num_entries += partition_combined.size(p);
+  }
+  if (static_cast<int>(num_entries) != data_gen->numEntries()) {
+    serr << "Partitions contain " << num_entries << " of " << data_gen->numEntries() << " entries." << endmsg;
+    ++num_failed;
+  }
+
+  RooCategory missing("missing", "missing");
+  missing.defineType("none", 0);
+  try {
+    CategoryPartition partition_missing(*data_gen, RooArgSet(missing));
+    serr << "No exception for category not in dataset." << endmsg;
+    ++num_failed;
+  } catch (int e) {
+    sinfo << "Category not in dataset rejected." << endmsg;
+  }
+
+  for (std::vector<RooDataSet*>::iterator it = datasets_single.begin(); it != datasets_single.end(); ++it) delete *it;
+  for (std::vector<RooDataSet*>::iterator it = datasets_combined.begin(); it != datasets_combined.end(); ++it) delete *it;
+  delete data_gen;
+  return num_failed;
+}
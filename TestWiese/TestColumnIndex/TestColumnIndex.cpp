@@ -0,0 +1,127 @@
+// from STL
+#include <string>
+#include <vector>
+#include <cmath>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/ColumnIndex.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Compare a range selection with a full pass over the dataset
+ *
+ *  @return 0 if count, weights, view and reduced dataset agree, 1 otherwise
+ */
+int CheckRange(const doocore::io::ColumnIndex& index, const RooAbsData& data, double min, double max) {
+  using namespace doocore::io;
+  std::vector<bool> selected(data.numEntries(), false);
+  std::size_t       num_reference = 0;
+  double            sum_weights   = 0.0;
+  for (int i=0; i<data.numEntries(); ++i) {
+    double value = data.get(i)->getRealValue("varMass");
+    if (value >= min && value <= max) {
+      selected[i] = true;
+      ++num_reference;
+      sum_weights += data.weight();
+    }
+  }
+
+  ColumnIndex::View view = index.Select(min, max);
+  if (view.size() != num_reference || index.Count(min, max) != num_reference) {
+    serr << "[" << min << "," << max << "]: " << view.size() << " entries vs. " << num_reference << " by full pass." << endmsg;
+    return 1;
+  }
+  double previous = -1e300;
+  for (const int* it = view.begin(); it != view.end(); ++it) {
+    double value = data.get(*it)->getRealValue("varMass");
+    if (!selected[*it] || value < previous) {
+      serr << "[" << min << "," << max << "]: Entry " << *it << " wrongly selected or out of order." << endmsg;
+      return 1;
+    }
+    previous = value;
+  }
+  if (std::abs(index.SumWeights(min, max)-sum_weights) > 1e-9*std::abs(sum_weights)) {
+    serr << "[" << min << "," << max << "]: Sum of weights " << index.SumWeights(min, max) << " vs. " 
+         << sum_weights << " by full pass." << endmsg;
+    return 1;
+  }
+
+  RooDataSet* reduced = index.CreateDataSet(min, max);
+  int num_reduced = reduced->numEntries();
+  delete reduced;
+  if (num_reduced != static_cast<int>(num_reference)) {
+    serr << "[" << min << "," << max << "]: Reduced dataset with " << num_reduced << " vs. " << num_reference 
+         << " entries by full pass." << endmsg;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ *  @brief Check a set of ranges including boundaries on existing values
+ *
+ *  @return number of failed ranges
+ */
+int CheckRanges(const std::string& description, const doocore::io::ColumnIndex& index, const RooAbsData& data) {
+  using namespace doocore::io;
+  int num_failed = 0;
+  for (double low=5450.0; low<5550.0; low+=7.0) {
+    num_failed += CheckRange(index, data, low, low+20.0);
+  }
+
+  // closed ranges with bounds on existing values, single values and empty ranges
+  const std::vector<double>& values = index.sorted_values();
+  num_failed += CheckRange(index, data, values[100], values[200]);
+  num_failed += CheckRange(index, data, values[300], values[300]);
+  num_failed += CheckRange(index, data, values.front(), values.back());
+  num_failed += CheckRange(index, data, 5520.0, 5480.0);
+  num_failed += CheckRange(index, data, 6500.0, 7000.0);
+
+  if (num_failed == 0) {
+    sinfo << description << ": All ranges identical to full pass." << endmsg;
+  }
+  return num_failed;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass), 10000);
+
+  int num_failed = 0;
+
+  ColumnIndex index(*data_gen, "varMass");
+  num_failed += CheckRanges("Unweighted", index, *data_gen);
+
+  RooRealVar varWeight("weight", "weight", 0, 10);
+  RooDataSet data_weighted("data_weighted", "data_weighted", RooArgSet(varMass, varWeight), RooFit::WeightVar("weight"));
+  for (int i=0; i<data_gen->numEntries(); ++i) {
+    varMass.setVal(data_gen->get(i)->getRealValue("varMass"));
+    data_weighted.add(RooArgSet(varMass), 0.5+(i%4));
+  }
+  ColumnIndex index_weighted(data_weighted, "varMass");
+  num_failed += CheckRanges("Weighted", index_weighted, data_weighted);
+
+  try {
+    ColumnIndex index_missing(*data_gen, "varMissing");
+    serr << "No exception for column not in dataset." << endmsg;
+    ++num_failed;
+  } catch (int e) {
+    sinfo << "Column not in dataset rejected." << endmsg;
+  }
+
+  delete data_gen;
+  return num_failed;
+}
@@ -12,6 +12,7 @@
 
 // from project
 #include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
 
 int main() {
   using namespace doocore::io;
@@ -41,4 +42,10 @@ int main() {
   varMassShift.Print();
   
   data.Print();
+
+  // column access without RooFit
+  EasyTuple etuple_columns("test.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  std::vector<double> masses = etuple_columns.Column<double>("varMass");
+  std::vector<int>    cats   = etuple_columns.Column<int>("cat");
+  sinfo << "Read " << masses.size() << " masses and " << cats.size() << " categories without RooFit." << endmsg;
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+// from STL
+#include <string>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from BOOST
+#include <boost/filesystem.hpp>
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Convert test tuple and get number of entries
+ *
+ *  @param cache_directory snapshot cache directory (empty to disable)
+ *  @param entry_list_directory entry list directory (empty to disable)
+ */
+int NumConverted(const RooArgSet& argset, const std::string& cut, const std::string& cache_directory,
+                 const std::string& entry_list_directory, doocore::io::VariableRangeCutting cut_variable_range) {
+  using namespace doocore::io;
+  EasyTuple etuple("test_cache.root", "Bs2Jpsif0", argset);
+  etuple.set_cache_directory(cache_directory);
+  etuple.set_entry_list_directory(entry_list_directory);
+  etuple.set_cut_variable_range(cut_variable_range);
+  return etuple.ConvertToDataSet(RooFit::Cut(cut.c_str())).numEntries();
+}
+
+/**
+ *  @brief Compare cached with uncached conversion
+ *
+ *  @return 0 if both agree, 1 otherwise
+ */
+int CheckConversion(const std::string& description, const RooArgSet& argset, const std::string& cut, 
+                    const std::string& cache_directory, const std::string& entry_list_directory="",
+                    doocore::io::VariableRangeCutting cut_variable_range=doocore::io::kCutInclusive) {
+  using namespace doocore::io;
+  int num_cached   = NumConverted(argset, cut, cache_directory, entry_list_directory, cut_variable_range);
+  int num_uncached = NumConverted(argset, cut, "", "", cut_variable_range);
+  if (num_cached != num_uncached) {
+    serr << description << ": " << num_cached << " entries with cache vs. " << num_uncached << " without." << endmsg;
+    return 1;
+  }
+  sinfo << description << ": " << num_cached << " entries as without cache." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_cache.root", "Bs2Jpsif0");
+
+  std::string snapshot_directory = "test_cache_snapshots";
+  boost::filesystem::remove_all(snapshot_directory);
+  boost::filesystem::create_directories(snapshot_directory);
+
+  int num_failed = 0;
+
+  // snapshots have to be invalidated by changed category states and ranges
+  RooRealVar  varMassSnapshot("varMass", "varMass", 5000, 6000);
+  RooCategory catSnapshot("cat", "cat");
+  catSnapshot.defineType("bla", 1);
+  catSnapshot.defineType("blub", 0);
+  num_failed += CheckConversion("Snapshot (write)", RooArgSet(varMassSnapshot, catSnapshot), "varMass>5490", snapshot_directory);
+  num_failed += CheckConversion("Snapshot (read)", RooArgSet(varMassSnapshot, catSnapshot), "varMass>5490", snapshot_directory);
+
+  RooCategory catSnapshotReduced("cat", "cat");
+  catSnapshotReduced.defineType("bla", 1);
+  num_failed += CheckConversion("Snapshot (changed category states)", RooArgSet(varMassSnapshot, catSnapshotReduced), 
+                                "varMass>5490", snapshot_directory);
+
+  varMassSnapshot.setRange(5000, 5510);
+  num_failed += CheckConversion("Snapshot (changed range)", RooArgSet(varMassSnapshot, catSnapshot), "varMass>5490", snapshot_directory);
+
+  // entry lists have to be invalidated by changed ranges even if not cut on
+  std::string entry_list_directory = "test_cache_entrylists";
+  boost::filesystem::remove_all(entry_list_directory);
+  boost::filesystem::create_directories(entry_list_directory);
+
+  RooRealVar varMassEntryList("varMass", "varMass", 5000, 6000);
+  num_failed += CheckConversion("Entry list (write)", RooArgSet(varMassEntryList, cat), "varMass>5490", 
+                                "", entry_list_directory, kNoCuts);
+  num_failed += CheckConversion("Entry list (read)", RooArgSet(varMassEntryList, cat), "varMass>5490", 
+                                "", entry_list_directory, kNoCuts);
+  varMassEntryList.setRange(5000, 5510);
+  num_failed += CheckConversion("Entry list (changed range)", RooArgSet(varMassEntryList, cat), "varMass>5490", 
+                                "", entry_list_directory, kNoCuts);
+  num_failed += CheckConversion("Entry list (exclusive range cut)", RooArgSet(varMassEntryList, cat), "varMass>5490", 
+                                "", entry_list_directory, kCutExclusive);
+
+  boost::filesystem::remove_all(snapshot_directory);
+  boost::filesystem::remove_all(entry_list_directory);
+  return num_failed;
+}
@@ -0,0 +1,102 @@
+// from STL
+#include <string>
+#include <vector>
+#include <cmath>
+
+// from ROOT
+#include "TFile.h"
+#include "TTree.h"
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooFormulaVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Compare two datasets entry by entry
+ *
+ *  @return true if both datasets contain the same entries in the same order
+ */
+bool CompareDataSets(const RooDataSet& data, const RooDataSet& reference) {
+  using namespace doocore::io;
+  if (data.numEntries() != reference.numEntries()) {
+    serr << "Number of entries differs: " << data.numEntries() << " vs. " << reference.numEntries() << endmsg;
+    return false;
+  }
+  for (int i=0; i<data.numEntries(); ++i) {
+    const RooArgSet* row     = data.get(i);
+    const RooArgSet* row_ref = reference.get(i);
+    double mass      = row->getRealValue("varMass");
+    double mass_ref  = row_ref->getRealValue("varMass");
+    double shift     = row->getRealValue("varMassShift");
+    double shift_ref = row_ref->getRealValue("varMassShift");
+    int    cat       = row->getCatIndex("cat");
+    int    cat_ref   = row_ref->getCatIndex("cat");
+    if (std::abs(mass-mass_ref) > 1e-9 || std::abs(shift-shift_ref) > 1e-9 || cat != cat_ref) {
+      serr << "Entry " << i << " differs: (" << mass << ", " << shift << ", " << cat << ") vs. (" 
+           << mass_ref << ", " << shift_ref << ", " << cat_ref << ")" << endmsg;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 100000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_conversion.root", "Bs2Jpsif0");
+
+  // integer literals have to be evaluated as in TFormula by compiled formulas
+  RooFormulaVar varMassShift("varMassShift", "varMassShift", "1/2*(@0-5000)+010", RooArgList(varMass));
+
+  std::vector<std::string> cuts;
+  cuts.push_back("varMass>5500");
+  cuts.push_back("cat==cat::bla");
+  cuts.push_back("cat==1 && varMass<5490");
+  cuts.push_back("(varMass-5500)*(varMass-5500)<100 || cat==cat::blub");
+
+  TFile  file("test_conversion.root");
+  TTree* tree = dynamic_cast<TTree*>(file.Get("Bs2Jpsif0"));
+
+  int num_failed = 0;
+  for (std::vector<std::string>::const_iterator it = cuts.begin(), end = cuts.end();
+       it != end; ++it) {
+    RooDataSet reference("reference", "reference", RooArgSet(varMass, cat), 
+                         RooFit::Import(*tree), RooFit::Cut(it->c_str()));
+    reference.addColumn(varMassShift);
+
+    for (int num_threads=1; num_threads<=2; ++num_threads) {
+      EasyTuple etuple("test_conversion.root", "Bs2Jpsif0", RooArgSet(varMass, cat, varMassShift));
+      etuple.set_num_threads(num_threads);
+      RooDataSet& data = etuple.ConvertToDataSet(RooFit::Cut(it->c_str()));
+
+      if (CompareDataSets(data, reference)) {
+        sinfo << "Cut '" << *it << "' (" << num_threads << " threads): " << data.numEntries() << " entries as in RooFit import." << endmsg;
+      } else {
+        serr << "Cut '" << *it << "' (" << num_threads << " threads): native conversion differs from RooFit import." << endmsg;
+        ++num_failed;
+      }
+    }
+  }
+  return num_failed;
+}
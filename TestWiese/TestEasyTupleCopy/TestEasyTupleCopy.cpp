@@ -0,0 +1,84 @@
+// from STL
+#include <string>
+#include <utility>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooArgList.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooFormulaVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Check whether a condition holds and report it
+ *
+ *  @return 0 if the condition holds, 1 otherwise
+ */
+int Check(const std::string& description, bool condition) {
+  using namespace doocore::io;
+  if (!condition) {
+    serr << description << ": Failed." << endmsg;
+    return 1;
+  }
+  sinfo << description << ": OK." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_copy.root", "Bs2Jpsif0");
+
+  int num_failed = 0;
+
+  EasyTuple   etuple("test_copy.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  RooDataSet& data = etuple.ConvertToDataSet();
+
+  // copies share the dataset for reading
+  EasyTuple        etuple_copy(etuple);
+  const EasyTuple& etuple_copy_const = etuple_copy;
+  num_failed += Check("Copy shares dataset", &etuple_copy.shared_dataset() == &data);
+  num_failed += Check("Const access does not copy", &etuple_copy_const.dataset() == &data && 
+                      &etuple_copy_const.Var("varMass") == data.get()->find("varMass"));
+
+  EasyTuple etuple_assigned("test_copy.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  etuple_assigned = etuple;
+  EasyTuple etuple_moved(std::move(etuple_assigned));
+  num_failed += Check("Assigned and moved copy shares dataset", &etuple_moved.shared_dataset() == &data);
+
+  // writing copies the dataset for the writing tuple only
+  RooFormulaVar varMassShift("varMassShift", "varMassShift", "@0-5.0", RooArgList(varMass));
+  etuple_copy.dataset().addColumn(varMassShift);
+  num_failed += Check("Write access copies dataset", &etuple_copy.shared_dataset() != &data);
+  num_failed += Check("Original dataset unchanged", &etuple.shared_dataset() == &data && 
+                      data.get()->find("varMassShift") == NULL && 
+                      etuple_copy.shared_dataset().get()->find("varMassShift") != NULL);
+  num_failed += Check("Other copies still share dataset", &etuple_moved.shared_dataset() == &data);
+  num_failed += Check("Copied dataset complete", etuple_copy.shared_dataset().numEntries() == data.numEntries());
+
+  // unshared datasets are not copied on write access
+  EasyTuple etuple_single("test_copy.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  RooDataSet& data_single = etuple_single.ConvertToDataSet();
+  num_failed += Check("Unshared dataset not copied", &etuple_single.dataset() == &data_single);
+
+  return num_failed;
+}
@@ -0,0 +1,126 @@
+// from STL
+#include <string>
+#include <cmath>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooDataHist.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooNumber.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Compare ConvertToDataHist() with binning the unbinned conversion
+ *
+ *  @return 0 if all bins agree, 1 otherwise
+ */
+int CheckDataHist(const std::string& description, const RooArgSet& argset, const std::string& cut, int num_threads) {
+  using namespace doocore::io;
+  EasyTuple etuple_binned("test_datahist.root", "Bs2Jpsif0", argset);
+  etuple_binned.set_num_threads(num_threads);
+  RooDataHist& data_binned = etuple_binned.ConvertToDataHist(cut);
+
+  EasyTuple etuple_unbinned("test_datahist.root", "Bs2Jpsif0", argset);
+  RooDataSet& data_unbinned = etuple_unbinned.ConvertToDataSet(RooFit::Cut(cut.c_str()));
+  RooDataHist reference("reference", "reference", argset, data_unbinned);
+
+  if (data_binned.numEntries() != reference.numEntries() || data_binned.sumEntries() != reference.sumEntries()) {
+    serr << description << ": " << data_binned.numEntries() << " bins with " << data_binned.sumEntries() 
+         << " entries vs. " << reference.numEntries() << " bins with " << reference.sumEntries() << " entries." << endmsg;
+    return 1;
+  }
+  for (int i=0; i<reference.numEntries(); ++i) {
+    data_binned.get(i);
+    reference.get(i);
+    if (data_binned.weight() != reference.weight()) {
+      serr << description << ": Bin " << i << " contains " << data_binned.weight() << " vs. " << reference.weight() 
+           << " entries." << endmsg;
+      return 1;
+    }
+  }
+  sinfo << description << ": " << data_binned.sumEntries() << " entries in identical bins." << endmsg;
+  return 0;
+}
+
+/**
+ *  @brief Compare a cut in ForEachChunk() and ConvertToCompactStore() with ConvertToDataSet()
+ *
+ *  @return number of conversions with a different number of entries
+ */
+int CheckCutSemantics(const std::string& description, const RooArgSet& argset, const std::string& cut) {
+  using namespace doocore::io;
+  EasyTuple   etuple_unbinned("test_datahist.root", "Bs2Jpsif0", argset);
+  std::size_t num_reference = etuple_unbinned.ConvertToDataSet(RooFit::Cut(cut.c_str())).numEntries();
+
+  EasyTuple   etuple_chunks("test_datahist.root", "Bs2Jpsif0", argset);
+  std::size_t num_chunks = 0;
+  etuple_chunks.ForEachChunk(1000, [&](const TupleChunk& chunk) { num_chunks += chunk.num_entries; }, cut);
+
+  EasyTuple   etuple_compact("test_datahist.root", "Bs2Jpsif0", argset);
+  std::size_t num_compact = etuple_compact.ConvertToCompactStore(cut).num_entries();
+
+  if (num_chunks != num_reference || num_compact != num_reference) {
+    serr << description << ": " << num_chunks << " entries in chunks and " << num_compact 
+         << " in compact store vs. " << num_reference << " in RooDataSet." << endmsg;
+    return 1;
+  }
+  sinfo << description << ": " << num_reference << " entries in all conversions." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_datahist.root", "Bs2Jpsif0");
+
+  int num_failed = 0;
+
+  RooRealVar varMassBinned("varMass", "varMass", 5450, 5550);
+  varMassBinned.setBins(40);
+  num_failed += CheckDataHist("DataHist", RooArgSet(varMassBinned, cat), "", 1);
+  num_failed += CheckDataHist("DataHist (cut)", RooArgSet(varMassBinned, cat), "varMass>5490", 1);
+  num_failed += CheckDataHist("DataHist (4 threads)", RooArgSet(varMassBinned, cat), "varMass>5490", 4);
+
+  // RooFormula cut semantics (category labels) in all conversions
+  std::string cut_label("varMass>5490&&cat==cat::bla");
+  num_failed += CheckDataHist("DataHist (category label)", RooArgSet(varMassBinned, cat), cut_label, 1);
+  num_failed += CheckDataHist("DataHist (category label, 4 threads)", RooArgSet(varMassBinned, cat), cut_label, 4);
+  num_failed += CheckCutSemantics("Chunks (category label)", RooArgSet(varMassBinned, cat), cut_label);
+
+  // variables without finite range cannot be binned
+  RooRealVar varMassUnbounded("varMass", "varMass", -RooNumber::infinity(), RooNumber::infinity());
+  try {
+    EasyTuple etuple("test_datahist.root", "Bs2Jpsif0", RooArgSet(varMassUnbounded, cat));
+    etuple.ConvertToDataHist();
+    serr << "DataHist (unbounded): No exception for variable without finite range." << endmsg;
+    ++num_failed;
+  } catch (int e) {
+    if (e != 12) {
+      serr << "DataHist (unbounded): Unexpected exception " << e << "." << endmsg;
+      ++num_failed;
+    } else {
+      sinfo << "DataHist (unbounded): Variable without finite range rejected." << endmsg;
+    }
+  }
+
+  return num_failed;
+}
@@ -0,0 +1,134 @@
+// from STL
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iomanip>
+
+// from ROOT
+#include "TRandom3.h"
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Expected entries after range and category cuts
+ */
+struct ExpectedEntries {
+  std::vector<double> mass;
+  std::vector<int>    cat;
+};
+
+/**
+ *  @brief Write a text file with random entries and get expected entries
+ *
+ *  Entries outside the mass range, with undefined category states and lines
+ *  with a wrong number of fields are written as well and must be rejected.
+ *
+ *  @param header write a header line with column names
+ */
+ExpectedEntries WriteTextFile(const std::string& file_name, bool header) {
+  TRandom3        random(42);
+  ExpectedEntries expected;
+  std::ofstream   file(file_name.c_str());
+  file << std::setprecision(17);
+  file << "# test file for EasyTuple::FromTextFile()" << std::endl;
+  if (header) file << "varMass, cat, varExtra" << std::endl;
+  for (int i=0; i<20000; ++i) {
+    double mass  = random.Gaus(5500, 100);
+    int    cat   = static_cast<int>(random.Integer(3));
+    double extra = random.Rndm();
+
+    if (i%1000 == 0) file << std::endl << "# comment" << std::endl;
+    if (i%997 == 0)  file << mass << " " << cat << std::endl;
+    if (i%2 == 0) {
+      file << mass << "," << cat << "," << extra;
+    } else {
+      file << mass << " \t" << cat << "  " << extra;
+    }
+    // last line without newline
+    if (i < 19999) file << std::endl;
+
+    if (mass >= 5000 && mass <= 6000 && cat <= 1) {
+      expected.mass.push_back(mass);
+      expected.cat.push_back(cat);
+    }
+  }
+  return expected;
+}
+
+/**
+ *  @brief Compare imported entries with expected entries
+ *
+ *  @return 0 if all entries agree, 1 otherwise
+ */
+int CheckImport(const std::string& description, const ExpectedEntries& expected, const std::string& file_name,
+                const RooArgSet& argset, const std::vector<std::string>& column_names, int num_threads) {
+  using namespace doocore::io;
+  EasyTuple   etuple(EasyTuple::FromTextFile(file_name, argset, column_names, num_threads));
+  const RooDataSet& data = etuple.shared_dataset();
+
+  if (data.numEntries() != static_cast<int>(expected.mass.size())) {
+    serr << description << ": " << data.numEntries() << " entries imported vs. " << expected.mass.size() << " expected." << endmsg;
+    return 1;
+  }
+  for (int i=0; i<data.numEntries(); ++i) {
+    const RooArgSet* row = data.get(i);
+    if (row->getRealValue("varMass") != expected.mass[i] || row->getCatIndex("cat") != expected.cat[i]) {
+      serr << description << ": Entry " << i << " differs (varMass " << row->getRealValue("varMass") << " vs. " 
+           << expected.mass[i] << ", cat " << row->getCatIndex("cat") << " vs. " << expected.cat[i] << ")." << endmsg;
+      return 1;
+    }
+  }
+  sinfo << description << ": " << data.numEntries() << " entries identical." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar  varMass("varMass", "varMass", 5000, 6000);
+  RooCategory cat("cat", "cat");
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  int num_failed = 0;
+
+  ExpectedEntries expected = WriteTextFile("test_textimport_header.txt", true);
+  num_failed += CheckImport("Header", expected, "test_textimport_header.txt", RooArgSet(varMass, cat), 
+                            std::vector<std::string>(), 1);
+  num_failed += CheckImport("Header (4 threads)", expected, "test_textimport_header.txt", RooArgSet(varMass, cat), 
+                            std::vector<std::string>(), 4);
+
+  WriteTextFile("test_textimport.txt", false);
+  std::vector<std::string> column_names = {"varMass", "cat", "varExtra"};
+  num_failed += CheckImport("Column names (4 threads)", expected, "test_textimport.txt", RooArgSet(varMass, cat), 
+                            column_names, 4);
+
+  RooRealVar varExtra("varExtra", "varExtra", 0, 1);
+  num_failed += CheckImport("Argset order (4 threads)", expected, "test_textimport.txt", RooArgSet(varMass, cat, varExtra), 
+                            std::vector<std::string>(), 4);
+
+  // no matching columns
+  try {
+    RooRealVar varOther("varOther", "varOther", 0, 1);
+    EasyTuple etuple(EasyTuple::FromTextFile("test_textimport_header.txt", RooArgSet(varOther)));
+    serr << "No exception for file without matching columns." << endmsg;
+    ++num_failed;
+  } catch (int e) {
+    if (e != 11) {
+      serr << "Unexpected exception " << e << " for file without matching columns." << endmsg;
+      ++num_failed;
+    } else {
+      sinfo << "File without matching columns rejected." << endmsg;
+    }
+  }
+
+  return num_failed;
+}
@@ -0,0 +1,82 @@
+// from STL
+#include <string>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Compare a written tree with the dataset it was written from
+ *
+ *  @return 0 if all entries agree, 1 otherwise
+ */
+int CheckRoundTrip(const std::string& description, const RooDataSet& data, const std::string& file_name,
+                   const RooArgSet& argset) {
+  using namespace doocore::io;
+  EasyTuple etuple(file_name, "Bs2Jpsif0", argset);
+  RooDataSet& data_read = etuple.ConvertToDataSet();
+
+  if (data_read.numEntries() != data.numEntries()) {
+    serr << description << ": " << data_read.numEntries() << " entries read vs. " << data.numEntries() << " written." << endmsg;
+    return 1;
+  }
+  for (int i=0; i<data.numEntries(); ++i) {
+    const RooArgSet* row      = data.get(i);
+    const RooArgSet* row_read = data_read.get(i);
+    double mass      = row->getRealValue("varMass");
+    double mass_read = row_read->getRealValue("varMass");
+    int    cat       = row->getCatIndex("cat");
+    int    cat_read  = row_read->getCatIndex("cat");
+    if (mass != mass_read || cat != cat_read) {
+      serr << description << ": Entry " << i << " differs (varMass " << mass_read << " vs. " << mass 
+           << ", cat " << cat_read << " vs. " << cat << ")." << endmsg;
+      return 1;
+    }
+  }
+  sinfo << description << ": " << data.numEntries() << " entries identical." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  int num_failed = 0;
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_write.root", "Bs2Jpsif0");
+  num_failed += CheckRoundTrip("Write", *data_gen, "test_write.root", RooArgSet(varMass, cat));
+
+  TreeWriteOptions options;
+  options.compression_level = 1;
+  options.auto_flush        = 1000;
+  etuple_gen.WriteDataSetToTree("test_write_options.root", "Bs2Jpsif0", options);
+  num_failed += CheckRoundTrip("Write (compression options)", *data_gen, "test_write_options.root", RooArgSet(varMass, cat));
+
+  // batch size not dividing the number of entries to test the final partial batch
+  TreeWriteOptions options_async;
+  options_async.asynchronous = true;
+  options_async.batch_size   = 333;
+  etuple_gen.WriteDataSetToTree("test_write_async.root", "Bs2Jpsif0", options_async);
+  num_failed += CheckRoundTrip("Write (asynchronous)", *data_gen, "test_write_async.root", RooArgSet(varMass, cat));
+
+  return num_failed;
+}
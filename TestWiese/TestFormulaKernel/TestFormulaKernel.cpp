@@ -0,0 +1,60 @@
+// from STL
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+// from RooFit
+#include "RooArgList.h"
+#include "RooRealVar.h"
+#include "RooFormulaVar.h"
+
+// from project
+#include "doocore/io/FormulaKernel.h"
+#include "doocore/io/MsgStream.h"
+
+int main() {
+  using namespace doocore::io;
+
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar varTime("varTime", "varTime", -2, 15);
+
+  std::vector<std::string> expressions;
+  expressions.push_back("1/2*@0");
+  expressions.push_back("(1/3)+@1");
+  expressions.push_back("010*varTime");
+  expressions.push_back("0.5e1*@0-00.25");
+  expressions.push_back("sqrt(@0*@0+@1*@1)/1000");
+  expressions.push_back("@1>2 && varMass<5500");
+
+  std::vector<double> masses = {5000.0, 5366.8, 5599.9, 6000.0};
+  std::vector<double> times  = {-1.5, 0.0, 2.0, 14.3};
+
+  int num_failed = 0;
+  for (std::vector<std::string>::const_iterator it = expressions.begin(), end = expressions.end();
+       it != end; ++it) {
+    RooFormulaVar formula("formula", "formula", it->c_str(), RooArgList(varMass, varTime));
+    FormulaKernel kernel(formula);
+    if (!kernel.IsCompiled()) {
+      swarn << "Formula '" << *it << "' not compiled, skipping." << endmsg;
+      continue;
+    }
+
+    std::vector<const double*> inputs = {masses.data(), times.data()};
+    std::vector<double>        values(masses.size());
+    kernel.Evaluate(inputs, values.data(), values.size());
+
+    for (std::size_t i=0; i<masses.size(); ++i) {
+      varMass.setVal(masses[i]);
+      varTime.setVal(times[i]);
+      double reference = formula.getVal();
+      if (std::abs(values[i]-reference) > 1e-12*std::max(1.0, std::abs(reference))) {
+        serr << "Formula '" << *it << "' at (" << masses[i] << ", " << times[i] << "): " 
+             << values[i] << " vs. RooFormulaVar " << reference << endmsg;
+        ++num_failed;
+      }
+    }
+  }
+  if (num_failed == 0) sinfo << "All compiled formulas agree with RooFormulaVar." << endmsg;
+  return num_failed;
+}
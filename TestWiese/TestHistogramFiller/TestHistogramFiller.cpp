@@ -0,0 +1,129 @@
+// from STL
+#include <string>
+#include <vector>
+#include <cmath>
+
+// from ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TH1.h"
+#include "TH2.h"
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+#include "RooGlobalFunc.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/HistogramFiller.h"
+#include "doocore/io/MsgStream.h"
+
+/**
+ *  @brief Histogram definition to compare against TTree::Draw()
+ */
+struct TestHistogram {
+  std::string name;
+  std::string expression;
+  std::string selection;
+  bool        two_dimensional;
+};
+
+/**
+ *  @brief Create an empty histogram for a definition
+ */
+TH1* CreateHistogram(const TestHistogram& definition, const std::string& name) {
+  if (definition.two_dimensional) {
+    return new TH2D(name.c_str(), name.c_str(), 50, 5400, 5600, 2, -0.5, 1.5);
+  } else {
+    return new TH1D(name.c_str(), name.c_str(), 50, 5400, 5600);
+  }
+}
+
+/**
+ *  @brief Compare all cells (including under- and overflow) of two histograms
+ *
+ *  @return 0 if both agree, 1 otherwise
+ */
+int CheckHistogram(const std::string& description, const TH1& histogram, const TH1& reference) {
+  using namespace doocore::io;
+  for (int i=0; i<reference.GetNcells(); ++i) {
+    double content           = histogram.GetBinContent(i);
+    double content_reference = reference.GetBinContent(i);
+    if (std::abs(content-content_reference) > 1e-9*std::abs(content_reference)) {
+      serr << description << ": Cell " << i << " contains " << content << " vs. " << content_reference 
+           << " from TTree::Draw()." << endmsg;
+      return 1;
+    }
+  }
+  sinfo << description << ": Identical to TTree::Draw()." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+  
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_histogramfiller.root", "Bs2Jpsif0");
+
+  // shared expressions and selections, a weight and a two-dimensional histogram
+  std::vector<TestHistogram> definitions = {
+    {"mass",          "varMass",       "",                      false},
+    {"mass_bla",      "varMass",       "cat==1",                false},
+    {"mass_shifted",  "varMass+20",    "cat==1",                false},
+    {"mass_weighted", "varMass",       "0.5*(varMass>5500)",    false},
+    {"cat_mass",      "cat:varMass",   "",                      true}
+  };
+
+  TFile file("test_histogramfiller.root");
+  TTree* tree = dynamic_cast<TTree*>(file.Get("Bs2Jpsif0"));
+  if (tree == NULL) {
+    serr << "Cannot read tree from test_histogramfiller.root." << endmsg;
+    return 1;
+  }
+
+  std::vector<TH1*> references, histograms_tree, histograms_files;
+  HistogramFiller filler_tree(*tree);
+  HistogramFiller filler_files(std::vector<std::string>(1, "test_histogramfiller.root"), "Bs2Jpsif0");
+  for (std::vector<TestHistogram>::const_iterator it = definitions.begin(); it != definitions.end(); ++it) {
+    TH1* reference = CreateHistogram(*it, "reference_"+it->name);
+    tree->Draw((it->expression+">>reference_"+it->name).c_str(), it->selection.c_str(), "goff");
+    references.push_back(reference);
+
+    histograms_tree.push_back(CreateHistogram(*it, "tree_"+it->name));
+    histograms_tree.back()->SetDirectory(NULL);
+    filler_tree.Add(*histograms_tree.back(), it->expression, it->selection);
+
+    histograms_files.push_back(CreateHistogram(*it, "files_"+it->name));
+    histograms_files.back()->SetDirectory(NULL);
+    filler_files.Add(*histograms_files.back(), it->expression, it->selection);
+  }
+
+  filler_tree.Fill();
+  filler_files.Fill(4);
+
+  int num_failed = 0;
+  for (std::size_t i=0; i<definitions.size(); ++i) {
+    num_failed += CheckHistogram("Tree "+definitions[i].name, *histograms_tree[i], *references[i]);
+    num_failed += CheckHistogram("Files (4 threads) "+definitions[i].name, *histograms_files[i], *references[i]);
+    delete histograms_tree[i];
+    delete histograms_files[i];
+  }
+
+  file.Close();
+  return num_failed;
+}
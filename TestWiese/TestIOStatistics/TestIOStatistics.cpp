@@ -0,0 +1,95 @@
+// from STL
+#include <string>
+#include <vector>
+#include <fstream>
+#include <utility>
+
+// from RooFit
+#include "RooDataSet.h"
+#include "RooArgSet.h"
+#include "RooCategory.h"
+#include "RooRealVar.h"
+#include "RooGaussian.h"
+
+// from project
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/IOStatistics.h"
+#include "doocore/io/MsgStream.h"
+#include "doocore/config/Summary.h"
+
+/// statistics received by RecordStatistics()
+std::vector<std::pair<std::string, doocore::io::IOStatistics> > received;
+
+void RecordStatistics(const std::string& task, const doocore::io::IOStatistics& statistics) {
+  received.push_back(std::make_pair(task, statistics));
+}
+
+/**
+ *  @brief Check whether a file contains a line
+ */
+bool ContainsLine(const std::string& file_name, const std::string& text) {
+  std::ifstream file(file_name.c_str());
+  std::string   line;
+  while (std::getline(file, line)) {
+    if (line.find(text) != std::string::npos) return true;
+  }
+  return false;
+}
+
+int main() {
+  using namespace doocore::io;
+
+  RooRealVar varMass("varMass", "varMass", 5000, 6000);
+  RooRealVar mean("mean", "mean", 5500, 5000, 6000);
+  RooRealVar sigma("sigma", "sigma", 10, 0, 50);
+  RooCategory cat("cat", "cat");
+
+  cat.defineType("bla", 1);
+  cat.defineType("blub", 0);
+
+  RooGaussian pdf("pdf", "pdf", varMass, mean, sigma);
+  RooDataSet* data_gen = pdf.generate(RooArgSet(varMass, cat), 10000);
+
+  EasyTuple etuple_gen(*data_gen);
+  etuple_gen.WriteDataSetToTree("test_iostatistics.root", "Bs2Jpsif0");
+
+  int num_failed = 0;
+
+  // statistics of conversions without handler are kept until a handler is set
+  EasyTuple etuple_early("test_iostatistics.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  RooDataSet& data_early = etuple_early.ConvertToDataSet();
+  SetIOStatisticsHandler(&RecordStatistics);
+  if (received.size() != 1 || received[0].first != "EasyTuple::ConvertToDataSet" ||
+      received[0].second.entries_accepted != data_early.numEntries()) {
+    serr << "Pending statistics: " << received.size() << " statistics received when setting the handler." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Pending statistics: Conversion before setting the handler received." << endmsg;
+  }
+
+  // with handler statistics are handed over immediately
+  EasyTuple etuple_late("test_iostatistics.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  etuple_late.ConvertToDataSet();
+  if (received.size() != 2) {
+    serr << "Handler: " << received.size() << " statistics received instead of 2." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Handler: Statistics received after conversion." << endmsg;
+  }
+  SetIOStatisticsHandler(IOStatisticsHandler());
+
+  // conversions before the Summary is created appear in the summary
+  EasyTuple etuple_summary("test_iostatistics.root", "Bs2Jpsif0", RooArgSet(varMass, cat));
+  etuple_summary.ConvertToDataSet();
+  doocore::config::Summary& summary = doocore::config::Summary::GetInstance();
+  summary.set_output_directory("test_iostatistics_summary");
+  summary.Write("test_iostatistics_summary.log");
+  if (!ContainsLine("test_iostatistics_summary.log", "EasyTuple::ConvertToDataSet I/O statistics")) {
+    serr << "Summary: Statistics of conversion before Summary::GetInstance() missing." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Summary: Statistics of conversion before Summary::GetInstance() written." << endmsg;
+  }
+
+  return num_failed;
+}
@@ -0,0 +1,501 @@
+// from STL
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <algorithm>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+
+// from BOOST
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/JsonLinesSink.h"
+
+/**
+ *  @brief Sink keeping all messages of the test stream
+ */
+class RecordingSink : public doocore::io::MsgSink {
+ public:
+  virtual void Write(const doocore::io::MsgRecord& record) {
+    if (record.name == NULL || std::string(record.name) != "test") return;
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    records_.push_back(record);
+  }
+
+  virtual void Flush() {}
+
+  /**
+   *  @brief Get and clear all recorded messages
+   */
+  std::vector<doocore::io::MsgRecord> Take() {
+    boost::lock_guard<boost::mutex> lock(mutex_);
+    std::vector<doocore::io::MsgRecord> records;
+    records.swap(records_);
+    return records;
+  }
+
+ private:
+  boost::mutex                        mutex_;
+  std::vector<doocore::io::MsgRecord> records_;
+};
+
+/// stream for test messages (recognised by its name)
+doocore::io::MsgStream stest(doocore::io::kTextNone, "", "test");
+
+const int kNumThreads  = 4;
+const int kNumMessages = 250;
+
+/**
+ *  @brief Print numbered messages in several parts
+ */
+void PrintMessages(int thread) {
+  using namespace doocore::io;
+  for (int i=0; i<kNumMessages; ++i) {
+    stest << "thread " << thread << " message " << i << endmsg;
+  }
+}
+
+/**
+ *  @brief Check that all messages of PrintMessages() arrived complete and in order per thread
+ *
+ *  @return 0 if all messages were recorded correctly, 1 otherwise
+ */
+int CheckMessages(const std::string& description, const std::vector<doocore::io::MsgRecord>& records) {
+  using namespace doocore::io;
+  if (records.size() != static_cast<std::size_t>(kNumThreads*kNumMessages)) {
+    serr << description << ": " << records.size() << " of " << kNumThreads*kNumMessages << " messages recorded." << endmsg;
+    return 1;
+  }
+
+  std::vector<int>                next_message(kNumThreads, 0);
+  std::vector<unsigned long long> sequences;
+  for (std::vector<MsgRecord>::const_iterator it = records.begin(); it != records.end(); ++it) {
+    std::istringstream text(it->text);
+    std::string        word_thread, word_message;
+    int                thread = -1, message = -1;
+    text >> word_thread >> thread >> word_message >> message;
+    if (word_thread != "thread" || word_message != "message" || thread < 0 || thread >= kNumThreads || 
+        message != next_message[thread] || !text.eof()) {
+      serr << description << ": Unexpected message \"" << it->text << "\"." << endmsg;
+      return 1;
+    }
+    ++next_message[thread];
+    sequences.push_back(it->sequence);
+  }
+
+  std::sort(sequences.begin(), sequences.end());
+  if (std::adjacent_find(sequences.begin(), sequences.end()) != sequences.end()) {
+    serr << description << ": Sequence numbers not unique." << endmsg;
+    return 1;
+  }
+  sinfo << description << ": All messages complete and in order." << endmsg;
+  return 0;
+}
+
+/**
+ *  @brief Print from several threads and check the recorded messages
+ *
+ *  @param toggle_asynchronous switch output modes while threads are printing
+ */
+int CheckThreads(const std::string& description, RecordingSink& sink, bool toggle_asynchronous) {
+  using namespace doocore::io;
+  boost::thread_group threads;
+  for (int t=0; t<kNumThreads; ++t) {
+    threads.create_thread(boost::bind(&PrintMessages, t));
+  }
+  if (toggle_asynchronous) {
+    for (int i=0; i<20; ++i) {
+      MsgStream::set_asynchronous(!MsgStream::asynchronous(), 16);
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+  }
+  threads.join_all();
+  MsgStream::FlushOutput();
+  return CheckMessages(description, sink.Take());
+}
+
+/**
+ *  @brief Print via short-lived streams, leaving unfinished messages behind
+ *
+ *  Identifiers of destroyed streams are reused by new streams, which must
+ *  not see the unfinished messages of their predecessors.
+ */
+void PrintShortLivedStreams(int thread) {
+  using namespace doocore::io;
+  for (int i=0; i<kNumMessages; ++i) {
+    {
+      MsgStream stream_unfinished(kTextNone, "", "test");
+      stream_unfinished << "unfinished ";
+    }
+    MsgStream stream(kTextNone, "", "test");
+    stream << "thread " << thread << " message " << i << endmsg;
+  }
+}
+
+/**
+ *  @brief Object printing on destruction at thread exit
+ */
+struct PrintOnThreadExit {
+  ~PrintOnThreadExit() {
+    stest << "thread exit" << doocore::io::endmsg;
+  }
+};
+
+/**
+ *  @brief Print at thread exit after the thread's message buffers are destroyed
+ */
+void PrintAtThreadExit() {
+  // constructed before and therefore destroyed after the message buffers
+  static thread_local PrintOnThreadExit print_on_exit;
+  (void)print_on_exit;
+  stest << "thread start" << doocore::io::endmsg;
+}
+
+/**
+ *  @brief Check per-thread buffers of short-lived streams and at thread exit
+ */
+int CheckThreadBuffers(RecordingSink& sink) {
+  using namespace doocore::io;
+  int num_failed = 0;
+
+  boost::thread_group threads;
+  for (int t=0; t<kNumThreads; ++t) {
+    threads.create_thread(boost::bind(&PrintShortLivedStreams, t));
+  }
+  threads.join_all();
+  MsgStream::FlushOutput();
+  num_failed += CheckMessages("Short-lived streams", sink.Take());
+
+  boost::thread thread(&PrintAtThreadExit);
+  thread.join();
+  MsgStream::FlushOutput();
+  std::vector<MsgRecord> records = sink.Take();
+  if (records.size() != 2 || records[0].text != "thread start" || records[1].text != "thread exit") {
+    serr << "Thread exit: Messages at thread exit not printed correctly." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Thread exit: Messages at thread exit printed correctly." << endmsg;
+  }
+  return num_failed;
+}
+
+/**
+ *  @brief Get texts of recorded messages
+ */
+std::vector<std::string> Texts(const std::vector<doocore::io::MsgRecord>& records) {
+  std::vector<std::string> texts;
+  for (std::vector<doocore::io::MsgRecord>::const_iterator it = records.begin(); it != records.end(); ++it) {
+    texts.push_back(it->text);
+  }
+  return texts;
+}
+
+/**
+ *  @brief Count evaluations of streamed expressions
+ */
+int num_evaluations = 0;
+int Evaluate() {
+  return ++num_evaluations;
+}
+
+/**
+ *  @brief Check that log macros evaluate and print only if the message is printed
+ */
+int CheckLogMacros(RecordingSink& sink) {
+  using namespace doocore::io;
+  int num_failed = 0;
+
+  stest.set_active(false);
+  DOOCORE_LOG(DOOCORE_LOG_LEVEL_ERROR, stest) << "inactive " << Evaluate() << endmsg;
+  stest.set_active(true);
+  DOOCORE_LOG(DOOCORE_LOG_LEVEL_ERROR, stest) << "active " << Evaluate() << endmsg;
+  DOOCORE_LOG(DOOCORE_LOG_LEVEL_DEBUG, stest) << "debug " << Evaluate() << endmsg;
+
+  // the macro must not take over a following else
+  if (num_evaluations < 0) DOOCORE_LOG(DOOCORE_LOG_LEVEL_ERROR, stest) << "if" << endmsg;
+  else stest << "else" << endmsg;
+
+  bool sdebug_active = sdebug.is_active();
+  sdebug.set_active(false);
+  DOOCORE_DEBUG << "inactive " << Evaluate() << endmsg;
+  sdebug.set_active(sdebug_active);
+
+  MsgStream::FlushOutput();
+  std::vector<std::string> expected;
+  expected.push_back("active 1");
+  if (DOOCORE_LOG_LEVEL_DEBUG >= DOOCORE_MIN_LOG_LEVEL) expected.push_back("debug 2");
+  expected.push_back("else");
+
+  std::vector<std::string> texts = Texts(sink.Take());
+  if (texts != expected || num_evaluations != static_cast<int>(expected.size())-1) {
+    serr << "Log macros: Printed " << texts << " with " << num_evaluations << " evaluations, expected " 
+         << expected << "." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Log macros: Only printed messages evaluated." << endmsg;
+  }
+  return num_failed;
+}
+
+/**
+ *  @brief Check JSON formatting including escaping
+ */
+int CheckJsonFormat() {
+  using namespace doocore::io;
+  MsgRecord record;
+  record.color    = kTextGreen;
+  record.indent   = 2;
+  record.text     = "a \"b\" \\ c\nd\te\x01";
+  record.thread   = 3;
+  record.sequence = 7;
+  record.time     = std::chrono::system_clock::time_point(std::chrono::microseconds(1000002));
+  record.name     = "info";
+
+  std::string json     = JsonLinesSink::FormatRecord(record);
+  std::string expected = "{\"seq\":7,\"time\":\"1970-01-01T00:00:01.000002Z\",\"level\":\"info\",\"color\":\"green\","
+                         "\"indent\":2,\"thread\":3,\"msg\":\"a \\\"b\\\" \\\\ c\\nd\\te\\u0001\"}";
+  if (json != expected) {
+    serr << "JSON format: " << json << " vs. expected " << expected << endmsg;
+    return 1;
+  }
+  sinfo << "JSON format: Formatted and escaped as expected." << endmsg;
+  return 0;
+}
+
+/**
+ *  @brief Read all lines of a file
+ *
+ *  @return false if the file does not exist
+ */
+bool ReadLines(const std::string& file_name, std::vector<std::string>& lines) {
+  std::ifstream file(file_name.c_str());
+  if (!file.good()) return false;
+  std::string line;
+  while (std::getline(file, line)) lines.push_back(line);
+  return true;
+}
+
+/**
+ *  @brief Check log file rotation of JsonLinesSink
+ */
+int CheckJsonRotation(RecordingSink& sink) {
+  using namespace doocore::io;
+  const std::string  file_name     = "test_msgstream.jsonl";
+  const std::size_t  max_file_size = 2000;
+  for (int i=0; i<=3; ++i) {
+    std::remove((i == 0 ? file_name : file_name+"."+std::to_string(i)).c_str());
+  }
+
+  {
+    std::shared_ptr<JsonLinesSink> json_sink(new JsonLinesSink(file_name, max_file_size, 2));
+    MsgStream::AddSink(json_sink);
+    for (int i=0; i<100; ++i) {
+      stest << "json message " << i << endmsg;
+    }
+    MsgStream::RemoveSink(json_sink);
+  }
+  // only checked in the log files
+  sink.Take();
+
+  std::vector<std::vector<std::string> > files(4);
+  bool exists[4];
+  for (int i=0; i<=3; ++i) {
+    exists[i] = ReadLines(i == 0 ? file_name : file_name+"."+std::to_string(i), files[i]);
+  }
+  if (!exists[0] || !exists[1] || !exists[2] || exists[3]) {
+    serr << "JSON rotation: Expected log file with two backups." << endmsg;
+    return 1;
+  }
+
+  // newest messages in the current file, older ones in the backups
+  int last_message = 100;
+  for (int i=0; i<=2; ++i) {
+    std::size_t size = 0;
+    for (std::vector<std::string>::const_reverse_iterator it = files[i].rbegin(); it != files[i].rend(); ++it) {
+      size += it->size()+1;
+      std::string prefix = "\"level\":\"test\"";
+      std::string suffix = "\"msg\":\"json message " + std::to_string(last_message-1) + "\"}";
+      if (it->compare(0, 7, "{\"seq\":") != 0 || it->find(prefix) == std::string::npos ||
+          it->size() < suffix.size() || it->compare(it->size()-suffix.size(), suffix.size(), suffix) != 0) {
+        serr << "JSON rotation: Unexpected line " << *it << endmsg;
+        return 1;
+      }
+      --last_message;
+    }
+    if (size > max_file_size) {
+      serr << "JSON rotation: File with " << size << " bytes exceeds maximum size." << endmsg;
+      return 1;
+    }
+  }
+  sinfo << "JSON rotation: Last " << 100-last_message << " messages in log file and backups." << endmsg;
+  return 0;
+}
+
+/**
+ *  @brief Print via one rate-limited call site (10 messages at once, 1 per second)
+ */
+void PrintRateLimited(int i) {
+  using namespace doocore::io;
+  DOOCORE_RATE_LIMITED(stest, 1.0, 10) << "limited " << i << endmsg;
+}
+
+/**
+ *  @brief Check rate limiting of a call site
+ */
+int CheckRateLimit(RecordingSink& sink) {
+  using namespace doocore::io;
+  for (int i=0; i<100; ++i) {
+    PrintRateLimited(i);
+  }
+  MsgStream::FlushOutput();
+  std::vector<std::string> texts = Texts(sink.Take());
+
+  // one more token might have been refilled meanwhile
+  std::size_t num_printed = texts.size();
+  bool        success     = num_printed == 10 || num_printed == 11;
+  for (std::size_t i=0; success && i<num_printed; ++i) {
+    success = texts[i] == "limited " + std::to_string(i);
+  }
+
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1100));
+  PrintRateLimited(100);
+  MsgStream::FlushOutput();
+  std::vector<std::string> expected;
+  expected.push_back("(" + std::to_string(100-num_printed) + " messages suppressed by rate limit)");
+  expected.push_back("limited 100");
+  texts = Texts(sink.Take());
+
+  if (!success || texts != expected) {
+    serr << "Rate limit: Unexpected messages (" << num_printed << " printed at once, then " << texts << ")." << endmsg;
+    return 1;
+  }
+  sinfo << "Rate limit: " << num_printed << " messages printed at once, suppressed ones reported." << endmsg;
+  return 0;
+}
+
+/**
+ *  @brief Check collapsing of repeated messages
+ */
+int CheckDeduplication(RecordingSink& sink) {
+  using namespace doocore::io;
+  int num_failed = 0;
+
+  MsgStream::set_deduplication_window(0.5);
+  for (int i=0; i<50; ++i) {
+    stest << "repeated" << endmsg;
+  }
+  stest << "other" << endmsg;
+  // counts are printed by the background thread after the window
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
+  MsgStream::FlushOutput();
+
+  std::vector<std::string> expected;
+  expected.push_back("repeated");
+  expected.push_back("other");
+  expected.push_back("repeated (repeated 49 times)");
+  std::vector<std::string> texts = Texts(sink.Take());
+  if (texts != expected) {
+    serr << "Deduplication: Printed " << texts << ", expected " << expected << "." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Deduplication: Repeated messages collapsed." << endmsg;
+  }
+
+  // disabling prints pending counts immediately
+  for (int i=0; i<3; ++i) {
+    stest << "pending" << endmsg;
+  }
+  MsgStream::set_deduplication_window(0);
+  MsgStream::FlushOutput();
+
+  expected.clear();
+  expected.push_back("pending");
+  expected.push_back("pending (repeated 2 times)");
+  texts = Texts(sink.Take());
+  if (texts != expected) {
+    serr << "Deduplication (disabled): Printed " << texts << ", expected " << expected << "." << endmsg;
+    ++num_failed;
+  } else {
+    sinfo << "Deduplication (disabled): Pending counts printed." << endmsg;
+  }
+  return num_failed;
+}
+
+/**
+ *  @brief Check destroying a stream with output file while repeats are pending
+ */
+int CheckDeduplicationFile(RecordingSink& sink) {
+  using namespace doocore::io;
+  const std::string file_name = "test_msgstream_dedup.log";
+  std::remove(file_name.c_str());
+
+  MsgStream::set_deduplication_window(0.5);
+  {
+    MsgStream sfile(kTextNone, file_name, "test");
+    for (int i=0; i<5; ++i) {
+      sfile << "file repeated" << endmsg;
+    }
+  }
+  // the background thread must not write to the closed file
+  boost::this_thread::sleep(boost::posix_time::milliseconds(1000));
+  MsgStream::set_deduplication_window(0);
+  MsgStream::FlushOutput();
+
+  std::vector<std::string> expected;
+  expected.push_back("file repeated");
+  expected.push_back("file repeated (repeated 4 times)");
+  std::vector<std::string> texts = Texts(sink.Take());
+  std::vector<std::string> lines;
+  if (!ReadLines(file_name, lines) || lines != expected || texts != expected) {
+    serr << "Deduplication (file): Printed " << texts << " and " << lines << " in file, expected " 
+         << expected << "." << endmsg;
+    return 1;
+  }
+  sinfo << "Deduplication (file): Pending count written before closing the file." << endmsg;
+  return 0;
+}
+
+int main() {
+  using namespace doocore::io;
+
+  std::shared_ptr<RecordingSink> sink(new RecordingSink());
+  MsgStream::AddSink(sink);
+
+  int num_failed = 0;
+
+  num_failed += CheckThreads("Synchronous", *sink, false);
+
+  // small ring buffer to make producers wait for free slots
+  MsgStream::set_asynchronous(true, 16);
+  num_failed += CheckThreads("Asynchronous", *sink, false);
+  MsgStream::set_asynchronous(false);
+
+  num_failed += CheckThreads("Switching modes", *sink, true);
+  MsgStream::set_asynchronous(false);
+
+  num_failed += CheckThreadBuffers(*sink);
+  MsgStream::set_asynchronous(true);
+  num_failed += CheckThreadBuffers(*sink);
+  MsgStream::set_asynchronous(false);
+
+  num_failed += CheckLogMacros(*sink);
+
+  num_failed += CheckJsonFormat();
+  num_failed += CheckJsonRotation(*sink);
+
+  num_failed += CheckRateLimit(*sink);
+  num_failed += CheckDeduplication(*sink);
+  MsgStream::set_asynchronous(true);
+  num_failed += CheckDeduplication(*sink);
+  num_failed += CheckDeduplicationFile(*sink);
+  MsgStream::set_asynchronous(false);
+  num_failed += CheckDeduplicationFile(*sink);
+
+  MsgStream::RemoveSink(sink);
+  return num_failed;
+}
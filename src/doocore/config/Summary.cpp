@@ -5,6 +5,7 @@
 #include <fstream>
 #include <iostream>
 #include <stdio.h>
+#include <functional>
 
 // from ROOT
 #include <TString.h>
@@ -21,6 +22,7 @@
 
 // from DooCore
 #include <doocore/io/MsgStream.h>
+#include <doocore/io/IOStatistics.h>
 
 namespace doocore {
 namespace config {
@@ -29,7 +31,16 @@ namespace config {
 Summary::Summary() :
   debug_mode_(false),
   output_directory_("summary")
-{}
+{
+  // write statistics of all EasyTuple conversions into the summary
+  doocore::io::SetIOStatisticsHandler(std::bind(&Summary::AddIOStatistics, this, 
+                                                std::placeholders::_1, std::placeholders::_2));
+}
+
+Summary::~Summary() {
+  doocore::io::SetIOStatisticsHandler(doocore::io::IOStatisticsHandler());
+  if (log_.size() > 0 || files_.size() > 0) CopyFiles();
+}
 
 Summary::Summary(const Summary&){}
 
@@ -102,6 +113,21 @@ void Summary::Add(TString description, int argument){
   if(debug_mode_) {doocore::io::sinfo << tpair.first  << " with value " << tpair.second << " saved to project summary." << doocore::io::endmsg;}
 }
 
+void Summary::AddIOStatistics(const std::string& task, const doocore::io::IOStatistics& statistics) {
+  const double megabyte = 1024.0*1024.0;
+  AddSection(task + " I/O statistics");
+  Add("MB read", statistics.bytes_read/megabyte);
+  Add("MB decompressed", statistics.bytes_decompressed/megabyte);
+  Add("read calls", boost::lexical_cast<std::string>(statistics.read_calls));
+  Add("entries scanned", boost::lexical_cast<std::string>(statistics.entries_scanned));
+  Add("entries accepted", boost::lexical_cast<std::string>(statistics.entries_accepted));
+  Add("time read (s)", statistics.time_read);
+  Add("time cut (s)", statistics.time_cut);
+  Add("time dataset insert (s)", statistics.time_dataset_insert);
+  Add("time addColumn (s)", statistics.time_add_column);
+  Add("time total (s)", statistics.time_total);
+}
+
 void Summary::AddSection(TString name){
   Add("Summary::SECTION", name);
 }
@@ -25,6 +25,7 @@
 
 // forward declarations
 class TCut;
+namespace doocore { namespace io { struct IOStatistics; } }
 
 namespace doocore {
 namespace config {
@@ -100,6 +101,19 @@ class Summary {
    *  @brief add a horizontal to the summary
    */
   void AddHLine();
+
+  /**
+   *  @brief Add I/O statistics of a tuple conversion to the summary
+   *
+   *  This is called automatically after each conversion in 
+   *  doocore::io::EasyTuple while the Summary exists. Statistics of 
+   *  conversions finished before the Summary was created are added upon 
+   *  its creation.
+   *
+   *  @param task description of the task
+   *  @param statistics statistics of the task
+   */
+  void AddIOStatistics(const std::string& task, const doocore::io::IOStatistics& statistics);
   
   /**
    *  @brief print the summary
@@ -165,9 +179,7 @@ class Summary {
   Summary(const Summary&);
 
   /// private destructor
-  ~Summary() {
-    if (log_.size() > 0 || files_.size() > 0) CopyFiles();
-  };
+  ~Summary();
   
   /**
    *  @brief Copy all previously added files to summary directory
@@ -0,0 +1,131 @@
+#include "doocore/io/CategoryPartition.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+
+// from RooFit
+#include "RooAbsData.h"
+#include "RooArgSet.h"
+#include "RooLinkedListIter.h"
+#include "RooAbsArg.h"
+#include "RooAbsCategory.h"
+#include "RooDataSet.h"
+#include "RooRealVar.h"
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+doocore::io::CategoryPartition::CategoryPartition(const RooAbsData& data, const RooArgSet& categories)
+: data_(data),
+  partition_of_entry_(data.numEntries(), -1)
+{
+  // category objects of the dataset's row, updated by each get(i)
+  const RooArgSet*                   row = data_.get();
+  std::vector<const RooAbsCategory*> row_categories;
+  RooLinkedListIter*                 it  = (RooLinkedListIter*)categories.createIterator();
+  RooAbsArg*                         arg = NULL;
+  while ((arg=(RooAbsArg*)it->Next())) {
+    const RooAbsCategory* category = row != NULL ? dynamic_cast<const RooAbsCategory*>(row->find(arg->GetName())) : NULL;
+    if (category == NULL) {
+      serr << "CategoryPartition: Category " << arg->GetName() << " not in dataset." << endmsg;
+      delete it;
+      throw 1;
+    }
+    row_categories.push_back(category);
+  }
+  delete it;
+
+  std::map<std::vector<int>, int> partitions;
+  std::vector<int>                states(row_categories.size());
+  for (int i=0; i<data_.numEntries(); ++i) {
+    data_.get(i);
+    for (std::size_t k=0; k<row_categories.size(); ++k) {
+      states[k] = row_categories[k]->getIndex();
+    }
+
+    std::map<std::vector<int>, int>::const_iterator it_partition = partitions.find(states);
+    int partition;
+    if (it_partition != partitions.end()) {
+      partition = it_partition->second;
+    } else {
+      partition = labels_.size();
+      partitions[states] = partition;
+
+      std::stringstream label;
+      if (row_categories.size() != 1) label << "{";
+      for (std::size_t k=0; k<row_categories.size(); ++k) {
+        label << (k > 0 ? ";" : "") << row_categories[k]->getLabel();
+      }
+      if (row_categories.size() != 1) label << "}";
+      labels_.push_back(label.str());
+      indices_.push_back(std::vector<int>());
+    }
+    indices_[partition].push_back(i);
+    partition_of_entry_[i] = partition;
+  }
+}
+
+int doocore::io::CategoryPartition::Find(const std::string& label) const {
+  for (std::size_t p=0; p<labels_.size(); ++p) {
+    if (labels_[p] == label) return p;
+  }
+  return -1;
+}
+
+const RooArgSet* doocore::io::CategoryPartition::Get(std::size_t partition, std::size_t entry) const {
+  return data_.get(indices_[partition][entry]);
+}
+
+double doocore::io::CategoryPartition::Weight() const {
+  return data_.weight();
+}
+
+std::vector<RooDataSet*> doocore::io::CategoryPartition::CreateDataSets() const {
+  std::vector<RooDataSet*> datasets;
+  for (std::size_t p=0; p<labels_.size(); ++p) {
+    datasets.push_back(CreateEmptyDataSet(p));
+  }
+
+  bool weighted = data_.isWeighted();
+  for (int i=0; i<data_.numEntries(); ++i) {
+    const RooArgSet* row = data_.get(i);
+    if (weighted) {
+      datasets[partition_of_entry_[i]]->add(*row, data_.weight());
+    } else {
+      datasets[partition_of_entry_[i]]->add(*row);
+    }
+  }
+  return datasets;
+}
+
+RooDataSet* doocore::io::CategoryPartition::CreateDataSet(std::size_t partition) const {
+  RooDataSet*             dataset  = CreateEmptyDataSet(partition);
+  bool                    weighted = data_.isWeighted();
+  const std::vector<int>& indices  = indices_[partition];
+  for (std::vector<int>::const_iterator it = indices.begin(), end = indices.end();
+       it != end; ++it) {
+    const RooArgSet* row = data_.get(*it);
+    if (weighted) {
+      dataset->add(*row, data_.weight());
+    } else {
+      dataset->add(*row);
+    }
+  }
+  return dataset;
+}
+
+RooDataSet* doocore::io::CategoryPartition::CreateEmptyDataSet(std::size_t partition) const {
+  std::string name = std::string(data_.GetName()) + "_" + labels_[partition];
+  if (!data_.isWeighted()) {
+    return new RooDataSet(name.c_str(), name.c_str(), *data_.get());
+  }
+
+  // RooFit allows no access to the weight's name, use 'weight' as in EasyTuple
+  RooRealVar weight("weight", "weight", 0.0);
+  RooArgSet  variables(*data_.get());
+  variables.add(weight);
+  return new RooDataSet(name.c_str(), name.c_str(), variables, "weight");
+}
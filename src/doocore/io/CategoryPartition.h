@@ -0,0 +1,185 @@
+#ifndef DOOCORE_IO_CATEGORYPARTITION_H
+#define DOOCORE_IO_CATEGORYPARTITION_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class RooAbsData;
+class RooArgSet;
+class RooDataSet;
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::CategoryPartition
+ * @brief Partition of a dataset by category states in a single pass
+ *
+ * CategoryPartition splits a dataset by the states of one or more category
+ * columns (e.g. trigger, magnet polarity, year) with one pass over the data
+ * instead of one RooAbsData::reduce() call per state. Each partition is kept
+ * as a list of entry indices into the original dataset. This index list can
+ * be used as a read-only view without copying. If RooDataSets are needed
+ * (e.g. for fitting), all of them are created in one more pass via
+ * CreateDataSets().
+ *
+ * Partitions are labelled with the state label for one category and with
+ * @c "{label1;label2}" (as in RooSuperCategory) for several categories. Only
+ * state combinations present in the data get a partition, in order of their
+ * first appearance.
+ *
+ * The partition keeps a reference to the dataset, which therefore has to
+ * exist and stay unchanged as long as the partition is used.
+ *
+ * @section cp_usage Usage
+ *
+ * @code
+ * RooDataSet& data = etuple.ConvertToDataSet();
+ * CategoryPartition partition(data, RooArgSet(catTrigger, catMagnet));
+ *
+ * // read-only view
+ * for (std::size_t p=0; p<partition.num_partitions(); ++p) {
+ *   double sum = 0.0;
+ *   for (std::size_t i=0; i<partition.size(p); ++i) {
+ *     sum += partition.Get(p, i)->getRealValue("varMass");
+ *   }
+ *   sinfo << partition.label(p) << ": " << sum/partition.size(p) << endmsg;
+ * }
+ *
+ * // copies for fitting
+ * std::vector<RooDataSet*> datasets = partition.CreateDataSets();
+ * @endcode
+ */
+class CategoryPartition {
+ public:
+  /**
+   *  @brief Constructor for CategoryPartition
+   *
+   *  Partitions @a data in one pass. If a category is not part of the
+   *  dataset, an exception is thrown.
+   *
+   *  @param data dataset to partition
+   *  @param categories categories to partition by
+   */
+  CategoryPartition(const RooAbsData& data, const RooArgSet& categories);
+
+  /**
+   *  @brief Get number of partitions
+   *
+   *  @return number of state combinations present in the data
+   */
+  std::size_t num_partitions() const { return labels_.size(); }
+
+  /**
+   *  @brief Get label of a partition
+   *
+   *  @param partition index of the partition
+   *  @return label of the state combination
+   */
+  const std::string& label(std::size_t partition) const { return labels_[partition]; }
+
+  /**
+   *  @brief Get entry indices of a partition in the original dataset
+   *
+   *  @param partition index of the partition
+   *  @return ascending entry indices
+   */
+  const std::vector<int>& indices(std::size_t partition) const { return indices_[partition]; }
+
+  /**
+   *  @brief Get number of entries in a partition
+   *
+   *  @param partition index of the partition
+   *  @return number of entries
+   */
+  std::size_t size(std::size_t partition) const { return indices_[partition].size(); }
+
+  /**
+   *  @brief Find partition by label
+   *
+   *  @param label label of the state combination
+   *  @return index of the partition or -1 if not present
+   */
+  int Find(const std::string& label) const;
+
+  /**
+   *  @brief Load entry of a partition from the original dataset
+   *
+   *  The returned row is the dataset's own row and is overwritten by the next
+   *  call (as for RooAbsData::get()).
+   *
+   *  @param partition index of the partition
+   *  @param entry entry number within the partition
+   *  @return row of the original dataset
+   */
+  const RooArgSet* Get(std::size_t partition, std::size_t entry) const;
+
+  /**
+   *  @brief Get weight of the entry last loaded via Get()
+   *
+   *  @return weight of the entry
+   */
+  double Weight() const;
+
+  /**
+   *  @brief Create RooDataSets for all partitions in one pass
+   *
+   *  Datasets are named after the original dataset and the partition label.
+   *  Weighted data is copied with a weight variable named @c weight.
+   *
+   *  @return new datasets in order of partitions (ownership passed to caller)
+   */
+  std::vector<RooDataSet*> CreateDataSets() const;
+
+  /**
+   *  @brief Create RooDataSet for one partition
+   *
+   *  @param partition index of the partition
+   *  @return new dataset (ownership passed to caller)
+   */
+  RooDataSet* CreateDataSet(std::size_t partition) const;
+
+ protected:
+
+ private:
+  /**
+   *  @brief Create empty RooDataSet with the variables of the original dataset
+   */
+  RooDataSet* CreateEmptyDataSet(std::size_t partition) const;
+
+  /**
+   *  @brief Dataset to partition
+   */
+  const RooAbsData& data_;
+
+  /**
+   *  @brief Labels of partitions
+   */
+  std::vector<std::string> labels_;
+
+  /**
+   *  @brief Entry indices per partition
+   */
+  std::vector<std::vector<int> > indices_;
+
+  /**
+   *  @brief Partition of each entry
+   */
+  std::vector<int> partition_of_entry_;
+}; // class CategoryPartition
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_CATEGORYPARTITION_H
@@ -0,0 +1,118 @@
+#include "doocore/io/ChainPrefetcher.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <memory>
+
+// from POSIX
+#include <fcntl.h>
+#include <unistd.h>
+
+// from ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+
+// from BOOST
+#include <boost/filesystem.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/Tools.h"
+
+doocore::io::ChainPrefetcher::ChainPrefetcher(const std::vector<std::string>& file_names,
+                                              const std::string& tree_name,
+                                              const std::vector<std::string>& branch_names)
+: file_names_(file_names),
+  tree_name_(tree_name),
+  branch_names_(branch_names),
+  current_file_(0),
+  stop_(false)
+{}
+
+doocore::io::ChainPrefetcher::~ChainPrefetcher() {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+void doocore::io::ChainPrefetcher::Start() {
+  if (file_names_.size() < 2 || thread_.joinable()) return;
+  doocore::io::tools::EnableRootThreadSafety();
+  thread_ = boost::thread(&ChainPrefetcher::Run, this);
+}
+
+void doocore::io::ChainPrefetcher::NotifyFile(int file_index) {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    current_file_ = file_index;
+  }
+  condition_.notify_all();
+}
+
+void doocore::io::ChainPrefetcher::Run() {
+  // the first file is opened by the main reader itself
+  int prefetched = 0;
+  while (true) {
+    int target;
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!stop_ && prefetched >= current_file_+1) condition_.wait(lock);
+      if (stop_) break;
+      target = current_file_+1;
+    }
+    if (target >= static_cast<int>(file_names_.size())) break;
+
+    Prefetch(file_names_[target]);
+    prefetched = target;
+  }
+}
+
+long long doocore::io::ChainPrefetcher::Prefetch(const std::string& file_name) {
+  // remote files would be transferred twice
+  if (!boost::filesystem::exists(file_name)) return 0;
+
+  std::unique_ptr<TFile> file(TFile::Open(file_name.c_str()));
+  if (!file || file->IsZombie()) {
+    swarn << "ChainPrefetcher: Cannot open " << file_name << " for prefetching." << endmsg;
+    return 0;
+  }
+  TTree* tree = dynamic_cast<TTree*>(file->Get(tree_name_.c_str()));
+  if (tree == NULL) return 0;
+
+  // baskets are requested from the operating system directly, bypassing 
+  // TFile and its global read counters
+  int descriptor = open(file_name.c_str(), O_RDONLY);
+  if (descriptor < 0) return 0;
+
+  long long bytes_requested = 0;
+  for (std::vector<std::string>::const_iterator it = branch_names_.begin(), end = branch_names_.end();
+       it != end; ++it) {
+    TBranch* branch = tree->GetBranch(it->c_str());
+    if (branch == NULL) continue;
+
+    // baskets already written to disk, read ahead into the page cache
+    Int_t     num_baskets  = branch->GetWriteBasket();
+    Long64_t* basket_seek  = branch->GetBasketSeek();
+    Int_t*    basket_bytes = branch->GetBasketBytes();
+    for (Int_t i=0; i<num_baskets; ++i) {
+      if (basket_bytes[i] <= 0) continue;
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        if (stop_) {
+          close(descriptor);
+          return bytes_requested;
+        }
+      }
+      if (posix_fadvise(descriptor, basket_seek[i], basket_bytes[i], POSIX_FADV_WILLNEED) == 0) {
+        bytes_requested += basket_bytes[i];
+      }
+    }
+  }
+  close(descriptor);
+  return bytes_requested;
+}
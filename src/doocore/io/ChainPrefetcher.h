@@ -0,0 +1,140 @@
+#ifndef DOOCORE_IO_CHAINPREFETCHER_H
+#define DOOCORE_IO_CHAINPREFETCHER_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+#include <boost/thread.hpp>
+
+// from here
+
+// forward declarations
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::ChainPrefetcher
+ * @brief Background prefetching of the next file in a chain of tuple files
+ *
+ * While one file of a chain is being processed, ChainPrefetcher opens the
+ * next file in a background thread and asks the operating system to read 
+ * ahead all baskets of the given branches. Subsequent reads of these baskets
+ * by the main reader are then served from the page cache instead of the
+ * (possibly shared) filesystem. The prefetcher stays at most one file ahead
+ * of the file reported via NotifyFile().
+ *
+ * Only local files (including network filesystems mounted locally) are 
+ * prefetched, remote files (e.g. @c root://) would be transferred twice. 
+ * Baskets are not read via TFile, so TFile's global read counters only 
+ * include the file's metadata read by the prefetcher.
+ *
+ * @section cp_usage Usage
+ *
+ * @code
+ * ChainPrefetcher prefetcher(file_names, "Bs2Jpsif0", branch_names);
+ * prefetcher.Start();
+ * // ... whenever the reader switches to file i:
+ * prefetcher.NotifyFile(i);
+ * @endcode
+ *
+ * Prefetching stops upon destruction.
+ */
+class ChainPrefetcher {
+ public:
+  /**
+   *  @brief Constructor for ChainPrefetcher
+   *
+   *  @param file_names files of the chain in order
+   *  @param tree_name name of the tree in each file
+   *  @param branch_names names of the branches to prefetch
+   */
+  ChainPrefetcher(const std::vector<std::string>& file_names, const std::string& tree_name,
+                  const std::vector<std::string>& branch_names);
+
+  /**
+   *  @brief Destructor for ChainPrefetcher, stopping the background thread
+   */
+  ~ChainPrefetcher();
+
+  /**
+   *  @brief Start background thread
+   */
+  void Start();
+
+  /**
+   *  @brief Report file currently processed
+   *
+   *  The background thread will prefetch the file following @a file_index.
+   *
+   *  @param file_index index of the currently processed file
+   */
+  void NotifyFile(int file_index);
+
+ protected:
+
+ private:
+  /**
+   *  @brief Main function of background thread
+   */
+  void Run();
+
+  /**
+   *  @brief Request read ahead of all baskets of the branches in a local file
+   *
+   *  @param file_name file to prefetch
+   *  @return number of bytes requested
+   */
+  long long Prefetch(const std::string& file_name);
+
+  /**
+   *  @brief Files of the chain
+   */
+  std::vector<std::string> file_names_;
+
+  /**
+   *  @brief Name of tree in files
+   */
+  std::string tree_name_;
+
+  /**
+   *  @brief Branches to prefetch
+   */
+  std::vector<std::string> branch_names_;
+
+  /**
+   *  @brief Index of file currently processed by the main reader
+   */
+  int current_file_;
+
+  /**
+   *  @brief Flag to stop the background thread
+   */
+  bool stop_;
+
+  /**
+   *  @brief Mutex for current_file_ and stop_
+   */
+  boost::mutex mutex_;
+
+  /**
+   *  @brief Condition to wake background thread
+   */
+  boost::condition_variable condition_;
+
+  /**
+   *  @brief Background thread
+   */
+  boost::thread thread_;
+}; // class ChainPrefetcher
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_CHAINPREFETCHER_H
@@ -0,0 +1,102 @@
+#include "doocore/io/ColumnIndex.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// from RooFit
+#include "RooAbsData.h"
+#include "RooArgSet.h"
+#include "RooAbsReal.h"
+#include "RooDataSet.h"
+#include "RooRealVar.h"
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+doocore::io::ColumnIndex::ColumnIndex(const RooAbsData& data, const std::string& column)
+: data_(data),
+  column_(column)
+{
+  const RooArgSet*  row   = data_.get();
+  const RooAbsReal* value = row != NULL ? dynamic_cast<const RooAbsReal*>(row->find(column.c_str())) : NULL;
+  if (value == NULL) {
+    serr << "ColumnIndex: Column " << column << " not in dataset or not real valued." << endmsg;
+    throw 1;
+  }
+
+  int                 num_entries = data_.numEntries();
+  bool                weighted    = data_.isWeighted();
+  std::vector<double> values(num_entries);
+  std::vector<double> weights(weighted ? num_entries : 0);
+  for (int i=0; i<num_entries; ++i) {
+    data_.get(i);
+    values[i] = value->getVal();
+    if (weighted) weights[i] = data_.weight();
+  }
+
+  permutation_.resize(num_entries);
+  for (int i=0; i<num_entries; ++i) {
+    permutation_[i] = i;
+  }
+  std::stable_sort(permutation_.begin(), permutation_.end(), [&values](int a, int b) {
+    return values[a] < values[b];
+  });
+
+  sorted_values_.resize(num_entries);
+  sorted_weights_.resize(weights.size());
+  for (int i=0; i<num_entries; ++i) {
+    sorted_values_[i] = values[permutation_[i]];
+    if (weighted) sorted_weights_[i] = weights[permutation_[i]];
+  }
+}
+
+doocore::io::ColumnIndex::View doocore::io::ColumnIndex::Select(double min, double max) const {
+  std::vector<double>::const_iterator first = std::lower_bound(sorted_values_.begin(), sorted_values_.end(), min);
+  std::vector<double>::const_iterator last  = std::upper_bound(first, sorted_values_.end(), max);
+  const int* indices = permutation_.data();
+  return View(indices + (first-sorted_values_.begin()), indices + (std::max(first, last)-sorted_values_.begin()));
+}
+
+double doocore::io::ColumnIndex::SumWeights(double min, double max) const {
+  View view = Select(min, max);
+  if (sorted_weights_.empty()) return view.size();
+
+  // weights are stored in the same order as the view
+  std::size_t first = view.begin()-permutation_.data();
+  double      sum   = 0.0;
+  for (std::size_t i=first; i<first+view.size(); ++i) {
+    sum += sorted_weights_[i];
+  }
+  return sum;
+}
+
+RooDataSet* doocore::io::ColumnIndex::CreateDataSet(double min, double max) const {
+  View             view = Select(min, max);
+  std::vector<int> entries(view.begin(), view.end());
+  std::sort(entries.begin(), entries.end());
+
+  std::string name     = std::string(data_.GetName()) + "_" + column_ + "_range";
+  bool        weighted = data_.isWeighted();
+  RooDataSet* dataset  = NULL;
+  if (weighted) {
+    RooRealVar weight("weight", "weight", 0.0);
+    RooArgSet  variables(*data_.get());
+    variables.add(weight);
+    dataset = new RooDataSet(name.c_str(), name.c_str(), variables, "weight");
+  } else {
+    dataset = new RooDataSet(name.c_str(), name.c_str(), *data_.get());
+  }
+
+  for (std::vector<int>::const_iterator it = entries.begin(), end = entries.end();
+       it != end; ++it) {
+    const RooArgSet* row = data_.get(*it);
+    if (weighted) {
+      dataset->add(*row, data_.weight());
+    } else {
+      dataset->add(*row);
+    }
+  }
+  return dataset;
+}
@@ -0,0 +1,177 @@
+#ifndef DOOCORE_IO_COLUMNINDEX_H
+#define DOOCORE_IO_COLUMNINDEX_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class RooAbsData;
+class RooArgSet;
+class RooDataSet;
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::ColumnIndex
+ * @brief Sorted index on one column of a dataset for fast range selections
+ *
+ * ColumnIndex sorts the entries of a dataset by the values of one real
+ * column once (O(n log n)). Afterwards, range selections on this column are
+ * found by binary search in O(log n) and returned as a View of the k matching
+ * entry indices without copying. Reduced datasets can be created from a
+ * range in O(k log k) instead of a full pass with RooAbsData::reduce().
+ *
+ * Ranges are closed, i.e. @c Select(min, max) selects min <= x <= max.
+ *
+ * The index keeps a reference to the dataset, which therefore has to exist
+ * and stay unchanged as long as the index is used.
+ *
+ * @section ci_usage Usage
+ *
+ * @code
+ * RooDataSet& data = etuple.ConvertToDataSet();
+ * ColumnIndex index(data, "varMass");
+ *
+ * for (double low=5200.0; low<5400.0; low+=1.0) {
+ *   ColumnIndex::View window = index.Select(low, low+20.0);
+ *   sinfo << "[" << low << "," << low+20.0 << "]: " << window.size() << " entries" << endmsg;
+ * }
+ *
+ * RooDataSet* sideband = index.CreateDataSet(5450.0, 5600.0);
+ * @endcode
+ */
+class ColumnIndex {
+ public:
+  /*! @class doocore::io::ColumnIndex::View
+   * @brief Read-only view of entry indices selected by a range
+   *
+   * Entries are ordered by increasing column value. The view is valid as
+   * long as the ColumnIndex exists.
+   */
+  class View {
+   public:
+    View(const int* first, const int* last) : first_(first), last_(last) {}
+
+    /// number of selected entries
+    std::size_t size() const { return last_-first_; }
+    /// entry index in the dataset of the i-th selected entry
+    int operator[](std::size_t i) const { return first_[i]; }
+    /// first selected entry index
+    const int* begin() const { return first_; }
+    /// end of selected entry indices
+    const int* end() const { return last_; }
+
+   private:
+    const int* first_;
+    const int* last_;
+  };
+
+  /**
+   *  @brief Constructor for ColumnIndex
+   *
+   *  Sorts the dataset's entries by @a column. If the column is not a real
+   *  valued column of the dataset, an exception is thrown.
+   *
+   *  @param data dataset to index
+   *  @param column name of the column to sort by
+   */
+  ColumnIndex(const RooAbsData& data, const std::string& column);
+
+  /**
+   *  @brief Select entries with column value in a range
+   *
+   *  @param min lower bound (inclusive)
+   *  @param max upper bound (inclusive)
+   *  @return view of the selected entry indices
+   */
+  View Select(double min, double max) const;
+
+  /**
+   *  @brief Count entries with column value in a range
+   *
+   *  @param min lower bound (inclusive)
+   *  @param max upper bound (inclusive)
+   *  @return number of entries
+   */
+  std::size_t Count(double min, double max) const { return Select(min, max).size(); }
+
+  /**
+   *  @brief Sum of weights of entries with column value in a range
+   *
+   *  For unweighted data this equals Count().
+   *
+   *  @param min lower bound (inclusive)
+   *  @param max upper bound (inclusive)
+   *  @return sum of weights
+   */
+  double SumWeights(double min, double max) const;
+
+  /**
+   *  @brief Create reduced dataset of entries with column value in a range
+   *
+   *  Entries keep their order of the original dataset. Weighted data is
+   *  copied with a weight variable named @c weight.
+   *
+   *  @param min lower bound (inclusive)
+   *  @param max upper bound (inclusive)
+   *  @return new dataset (ownership passed to caller)
+   */
+  RooDataSet* CreateDataSet(double min, double max) const;
+
+  /**
+   *  @brief Get column values in ascending order
+   *
+   *  @return sorted column values
+   */
+  const std::vector<double>& sorted_values() const { return sorted_values_; }
+
+  /**
+   *  @brief Get entry indices ordered by column value
+   *
+   *  @return permutation of entry indices
+   */
+  const std::vector<int>& permutation() const { return permutation_; }
+
+ protected:
+
+ private:
+  /**
+   *  @brief Indexed dataset
+   */
+  const RooAbsData& data_;
+
+  /**
+   *  @brief Name of the indexed column
+   */
+  std::string column_;
+
+  /**
+   *  @brief Column values in ascending order
+   */
+  std::vector<double> sorted_values_;
+
+  /**
+   *  @brief Entry indices ordered by column value
+   */
+  std::vector<int> permutation_;
+
+  /**
+   *  @brief Weights ordered by column value (empty for unweighted data)
+   */
+  std::vector<double> sorted_weights_;
+}; // class ColumnIndex
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_COLUMNINDEX_H
@@ -0,0 +1,169 @@
+#include "doocore/io/CompactColumnStore.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+
+// from RooFit
+#include "RooArgSet.h"
+#include "RooAbsArg.h"
+#include "RooDataSet.h"
+#include "RooRealVar.h"
+#include "RooCategory.h"
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+doocore::io::CompactColumnStore::CompactColumnStore(const std::vector<std::string>& names,
+                                                    const std::vector<ColumnType>& types,
+                                                    const std::vector<bool>& is_category)
+: columns_(names.size()),
+  num_entries_(0)
+{
+  for (std::size_t i=0; i<names.size(); ++i) {
+    columns_[i].name        = names[i];
+    columns_[i].is_category = is_category[i];
+    // categories start with 8 bit codes and are widened if needed
+    columns_[i].type        = is_category[i] ? kColumnUChar : types[i];
+  }
+}
+
+void doocore::io::CompactColumnStore::AddEntries(const std::vector<std::vector<double> >& columns, std::size_t num_entries) {
+  for (std::size_t i=0; i<columns_.size(); ++i) {
+    Column&       column = columns_[i];
+    const double* values = columns[i].data();
+
+    if (column.is_category && column.type == kColumnUChar) {
+      column.data.reserve(column.data.size() + num_entries);
+      std::size_t j = 0;
+      for (; j<num_entries; ++j) {
+        int index = static_cast<int>(values[j]);
+        std::map<int, unsigned char>::const_iterator code = column.category_codes.find(index);
+        if (code != column.category_codes.end()) {
+          column.data.push_back(static_cast<char>(code->second));
+        } else if (column.category_indices.size() <= std::numeric_limits<unsigned char>::max()) {
+          unsigned char new_code = column.category_indices.size();
+          column.category_codes[index] = new_code;
+          column.category_indices.push_back(index);
+          column.data.push_back(static_cast<char>(new_code));
+        } else {
+          break;
+        }
+      }
+      if (j == num_entries) continue;
+
+      // more than 256 states: store category indices directly from now on
+      std::vector<char> coded;
+      coded.swap(column.data);
+      column.data.reserve(sizeof(Int_t)*(coded.size() + num_entries));
+      for (std::size_t k=0; k<coded.size(); ++k) {
+        Put<Int_t>(column.data, column.category_indices[static_cast<unsigned char>(coded[k])]);
+      }
+      column.type = kColumnInt;
+      column.category_indices.clear();
+      column.category_codes.clear();
+      for (; j<num_entries; ++j) {
+        Put<Int_t>(column.data, values[j]);
+      }
+      continue;
+    }
+
+    switch (column.type) {
+      case kColumnDouble:  for (std::size_t j=0; j<num_entries; ++j) Put<Double_t>(column.data, values[j]);  break;
+      case kColumnFloat:   for (std::size_t j=0; j<num_entries; ++j) Put<Float_t>(column.data, values[j]);   break;
+      case kColumnLong64:  for (std::size_t j=0; j<num_entries; ++j) Put<Long64_t>(column.data, values[j]);  break;
+      case kColumnULong64: for (std::size_t j=0; j<num_entries; ++j) Put<ULong64_t>(column.data, values[j]); break;
+      case kColumnInt:     for (std::size_t j=0; j<num_entries; ++j) Put<Int_t>(column.data, values[j]);     break;
+      case kColumnUInt:    for (std::size_t j=0; j<num_entries; ++j) Put<UInt_t>(column.data, values[j]);    break;
+      case kColumnShort:   for (std::size_t j=0; j<num_entries; ++j) Put<Short_t>(column.data, values[j]);   break;
+      case kColumnUShort:  for (std::size_t j=0; j<num_entries; ++j) Put<UShort_t>(column.data, values[j]);  break;
+      case kColumnChar:    for (std::size_t j=0; j<num_entries; ++j) Put<Char_t>(column.data, values[j]);    break;
+      case kColumnUChar:   for (std::size_t j=0; j<num_entries; ++j) Put<UChar_t>(column.data, values[j]);   break;
+      case kColumnBool:    for (std::size_t j=0; j<num_entries; ++j) Put<UChar_t>(column.data, values[j]);   break;
+    }
+  }
+  num_entries_ += num_entries;
+}
+
+double doocore::io::CompactColumnStore::Value(std::size_t column, std::size_t entry) const {
+  const Column& col  = columns_[column];
+  const char*   data = col.data.data();
+  if (col.is_category && col.type == kColumnUChar) {
+    return col.category_indices[static_cast<unsigned char>(data[entry])];
+  }
+
+  switch (col.type) {
+    case kColumnDouble:  return Get<Double_t>(data, entry);
+    case kColumnFloat:   return Get<Float_t>(data, entry);
+    case kColumnLong64:  return Get<Long64_t>(data, entry);
+    case kColumnULong64: return Get<ULong64_t>(data, entry);
+    case kColumnInt:     return Get<Int_t>(data, entry);
+    case kColumnUInt:    return Get<UInt_t>(data, entry);
+    case kColumnShort:   return Get<Short_t>(data, entry);
+    case kColumnUShort:  return Get<UShort_t>(data, entry);
+    case kColumnChar:    return Get<Char_t>(data, entry);
+    case kColumnUChar:   return Get<UChar_t>(data, entry);
+    case kColumnBool:    return Get<UChar_t>(data, entry);
+  }
+  return 0.0;
+}
+
+RooDataSet* doocore::io::CompactColumnStore::CreateDataSet(const RooArgSet& variables) const {
+  RooArgSet                columns_set;
+  std::vector<std::size_t> column_indices;
+  for (std::size_t i=0; i<columns_.size(); ++i) {
+    RooAbsArg* arg = variables.find(columns_[i].name.c_str());
+    bool       matches = columns_[i].is_category ? dynamic_cast<RooCategory*>(arg) != NULL
+                                                 : dynamic_cast<RooRealVar*>(arg) != NULL;
+    if (!matches) {
+      swarn << "CompactColumnStore::CreateDataSet(...): No matching variable for column " << columns_[i].name << ". Skipping column." << endmsg;
+      continue;
+    }
+    columns_set.add(*arg);
+    column_indices.push_back(i);
+  }
+
+  RooDataSet*      dataset = new RooDataSet("dataset", "dataset", columns_set);
+  const RooArgSet* row     = dataset->get();
+
+  std::vector<RooRealVar*>  row_reals(column_indices.size(), NULL);
+  std::vector<RooCategory*> row_cats(column_indices.size(), NULL);
+  for (std::size_t k=0; k<column_indices.size(); ++k) {
+    const Column& column = columns_[column_indices[k]];
+    if (column.is_category) {
+      row_cats[k]  = dynamic_cast<RooCategory*>(row->find(column.name.c_str()));
+    } else {
+      row_reals[k] = dynamic_cast<RooRealVar*>(row->find(column.name.c_str()));
+    }
+  }
+
+  for (std::size_t entry=0; entry<num_entries_; ++entry) {
+    for (std::size_t k=0; k<column_indices.size(); ++k) {
+      if (row_cats[k] != NULL) {
+        row_cats[k]->setIndex(static_cast<int>(Value(column_indices[k], entry)));
+      } else {
+        row_reals[k]->setVal(Value(column_indices[k], entry));
+      }
+    }
+    dataset->add(*row);
+  }
+  return dataset;
+}
+
+int doocore::io::CompactColumnStore::Index(const std::string& name) const {
+  for (std::size_t i=0; i<columns_.size(); ++i) {
+    if (columns_[i].name == name) return i;
+  }
+  return -1;
+}
+
+std::size_t doocore::io::CompactColumnStore::MemorySize() const {
+  std::size_t size = 0;
+  for (std::vector<Column>::const_iterator it = columns_.begin(), end = columns_.end();
+       it != end; ++it) {
+    size += it->data.size();
+  }
+  return size;
+}
@@ -0,0 +1,198 @@
+#ifndef DOOCORE_IO_COMPACTCOLUMNSTORE_H
+#define DOOCORE_IO_COMPACTCOLUMNSTORE_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+#include "doocore/io/TreeColumnReader.h"
+
+// forward declarations
+class RooArgSet;
+class RooDataSet;
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::CompactColumnStore
+ * @brief Columnar in-memory store keeping the storage types of tuple branches
+ *
+ * CompactColumnStore holds converted tuple data column by column in the
+ * branches' own types instead of one double per value: @c Float_t branches
+ * take 4 bytes per entry, @c Bool_t branches 1 byte and so on. Category
+ * columns are stored as 8 bit codes into a table of category indices (as
+ * long as the category has at most 256 states).
+ *
+ * RooFit's data stores always keep doubles, therefore fitting requires a
+ * RooDataSet created via CreateDataSet(). This dataset is a materialised
+ * copy and can be deleted after the fit while the compact store stays
+ * resident.
+ *
+ * @section ccs_usage Usage
+ *
+ * CompactColumnStore is normally filled via
+ * doocore::io::EasyTuple::ConvertToCompactStore():
+ *
+ * @code
+ * EasyTuple etuple("tuplefile.root", "Bs2Jpsif0", RooArgSet(varMass,catTag));
+ * const CompactColumnStore& store = etuple.ConvertToCompactStore("varMass>5200");
+ * sinfo << "Store uses " << store.MemorySize() << " bytes." << endmsg;
+ *
+ * RooDataSet* data = store.CreateDataSet(RooArgSet(varMass,catTag));
+ * // fit...
+ * delete data;
+ * @endcode
+ */
+class CompactColumnStore {
+ public:
+  /**
+   *  @brief Constructor for CompactColumnStore
+   *
+   *  @param names names of the columns
+   *  @param types storage types of the columns
+   *  @param is_category flags marking category columns
+   */
+  CompactColumnStore(const std::vector<std::string>& names, const std::vector<ColumnType>& types,
+                     const std::vector<bool>& is_category);
+
+  /**
+   *  @brief Append entries from column buffers
+   *
+   *  Values are converted into the storage type of each column.
+   *
+   *  @param columns one buffer per column with at least num_entries values each
+   *  @param num_entries number of entries to append
+   */
+  void AddEntries(const std::vector<std::vector<double> >& columns, std::size_t num_entries);
+
+  /**
+   *  @brief Get value of a column for an entry
+   *
+   *  @param column index of the column
+   *  @param entry entry number
+   *  @return value converted to double (category index for category columns)
+   */
+  double Value(std::size_t column, std::size_t entry) const;
+
+  /**
+   *  @brief Create a RooDataSet with all entries of the store
+   *
+   *  Columns are matched by name to the variables in @a variables, columns
+   *  without matching variable are skipped.
+   *
+   *  @param variables variables to use for the dataset columns
+   *  @return new RooDataSet (ownership passed to caller)
+   */
+  RooDataSet* CreateDataSet(const RooArgSet& variables) const;
+
+  /**
+   *  @brief Get index of a column by name
+   *
+   *  @param name name of the column
+   *  @return index of the column or -1 if not found
+   */
+  int Index(const std::string& name) const;
+
+  /**
+   *  @brief Get number of bytes used for column data
+   *
+   *  @return number of bytes
+   */
+  std::size_t MemorySize() const;
+
+  /**
+   *  @brief Get number of entries
+   *
+   *  @return number of entries
+   */
+  std::size_t num_entries() const { return num_entries_; }
+
+  /**
+   *  @brief Get number of columns
+   *
+   *  @return number of columns
+   */
+  std::size_t num_columns() const { return columns_.size(); }
+
+  /**
+   *  @brief Get name of a column
+   *
+   *  @param column index of the column
+   *  @return name of the column
+   */
+  const std::string& name(std::size_t column) const { return columns_[column].name; }
+
+  /**
+   *  @brief Get storage type of a column
+   *
+   *  @param column index of the column
+   *  @return storage type of the column
+   */
+  ColumnType type(std::size_t column) const { return columns_[column].type; }
+
+ protected:
+
+ private:
+  /**
+   *  @brief Column data and description
+   */
+  struct Column {
+    /// name of the column
+    std::string                name;
+    /// storage type of the column
+    ColumnType                 type;
+    /// whether this column holds category indices
+    bool                       is_category;
+    /// category indices for 8 bit codes (empty if not coded)
+    std::vector<int>           category_indices;
+    /// 8 bit codes of category indices (empty if not coded)
+    std::map<int, unsigned char> category_codes;
+    /// raw column data
+    std::vector<char>          data;
+  };
+
+  /**
+   *  @brief Read value of type T from raw data
+   */
+  template<typename T>
+  static double Get(const char* data, std::size_t entry) {
+    T value;
+    std::memcpy(&value, data+entry*sizeof(T), sizeof(T));
+    return static_cast<double>(value);
+  }
+
+  /**
+   *  @brief Append value of type T to raw data
+   */
+  template<typename T>
+  static void Put(std::vector<char>& data, double value) {
+    T converted = static_cast<T>(value);
+    const char* bytes = reinterpret_cast<const char*>(&converted);
+    data.insert(data.end(), bytes, bytes+sizeof(T));
+  }
+
+  /**
+   *  @brief Columns of the store
+   */
+  std::vector<Column> columns_;
+
+  /**
+   *  @brief Number of entries
+   */
+  std::size_t num_entries_;
+}; // class CompactColumnStore
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_COMPACTCOLUMNSTORE_H
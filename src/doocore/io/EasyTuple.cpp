@@ -4,182 +4,1274 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <set>
+#include <limits>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include <chrono>
+#include <cmath>
+
+// from POSIX
+#include <glob.h>
 
 // from Boost
 #include <boost/assign/std/vector.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
 using namespace boost::assign;
 
 // from ROOT
 #include "TFile.h"
 #include "TTree.h"
+#include "TChain.h"
+#include "TTreeCache.h"
 #include "TBranch.h"
+#include "TRandom3.h"
 
 // from RooFit
 #include "RooArgSet.h"
 #include "RooLinkedListIter.h"
 #include "RooAbsArg.h"
+#include "RooAbsReal.h"
+#include "RooAbsCategory.h"
 #include "RooDataSet.h"
+#include "RooDataHist.h"
+#include "RooAbsBinning.h"
 #include "RooFormulaVar.h"
 #include "RooCategory.h"
 #include "RooRealVar.h"
 #include "RooCmdArg.h"
+#include "RooConstVar.h"
 
 // from project
 #include <doocore/io/MsgStream.h>
 #include <doocore/io/Progress.h>
+#include <doocore/io/SnapshotCache.h>
+#include <doocore/io/EntryListCache.h>
+#include <doocore/io/TreeColumnReader.h>
+#include <doocore/io/ChainPrefetcher.h>
+#include <doocore/io/Tools.h>
+#include <doocore/io/IOStatistics.h>
+#include <doocore/io/FormulaKernel.h>
+#include <doocore/io/TextFileParser.h>
 
 using namespace ROOT;
 using namespace RooFit;
 
-doocore::io::EasyTuple::EasyTuple(const std::string& file_name, const std::string& tree_name, const RooArgSet& argset)
-: file_(NULL),
-  tree_(NULL),
-  argset_(NULL),
-  dataset_(NULL),
-  tree_name_(tree_name),
-  num_maximum_events_(-1),
-  cut_variable_range_(kCutInclusive)
-{
-  file_ = new TFile(file_name.c_str());
-  argset_ = new RooArgSet(argset);
-  
-  if (file_ == NULL || file_->IsZombie() || file_->GetNkeys() <= 0) {
-    serr << "File " << file_name << " could not be opened properly." << endmsg;
-    throw 1;
+namespace {
+/**
+ *  @brief Specification of a column for native conversion
+ *
+ *  Contains all information needed to check an entry's validity without 
+ *  touching RooFit objects (and therefore usable in worker threads).
+ */
+struct ImportColumn {
+  std::string   name;
+  bool          is_category;
+  double        min;
+  double        max;
+  bool          min_inclusive;
+  bool          max_inclusive;
+  std::set<int> valid_indices;
+};
+
+/**
+ *  @brief Number of entries read at once before range cuts are applied
+ */
+const std::size_t kImportBlockSize = 4096;
+
+/**
+ *  @brief Column-wise buffer of accepted entries from native conversion
+ */
+struct ImportBuffer {
+  ImportBuffer() : num_entries(0), success(false), cache_efficiency(-1.0) {}
+  std::vector<std::vector<double> > columns;
+  std::size_t                       num_entries;
+  bool                              success;
+  /// efficiency of the worker's read cache (negative if unknown)
+  double                            cache_efficiency;
+  /// tree entry numbers of accepted entries (only if recorded)
+  std::vector<Long64_t>             entries;
+  /// entry counts and read/cut timers of this buffer
+  doocore::io::IOStatistics         statistics;
+};
+
+/**
+ *  @brief Range of entries to import
+ *
+ *  If entries is set, first and last refer to positions in this ascending 
+ *  list of tree entry numbers instead of tree entries directly.
+ */
+struct ImportRange {
+  ImportRange(Long64_t first_entry, Long64_t last_entry) 
+  : first(first_entry), last(last_entry), entries(NULL), record_entries(false) {}
+  Long64_t                     first;
+  Long64_t                     last;
+  const std::vector<Long64_t>* entries;
+  bool                         record_entries;
+};
+
+/**
+ *  @brief Number of tree entries per chunk for compact store conversion
+ */
+const std::size_t kCompactChunkSize = 65536;
+
+/**
+ *  @brief Number of tree entries per chunk for histogram filling
+ */
+const Long64_t kHistogramChunkSize = 65536;
+
+/**
+ *  @brief Number of baskets per active branch the read cache is sized for
+ */
+const Long64_t kCacheBasketsPerBranch = 10;
+
+/**
+ *  @brief Limits for the read cache size in bytes
+ */
+const Long64_t kCacheSizeMin = 1024*1024;
+const Long64_t kCacheSizeMax = 256*1024*1024;
+
+/**
+ *  @brief Number of entries in the learning phase of the read cache
+ */
+const Int_t kCacheLearnEntries = 100;
+
+/**
+ *  @brief Set up a TTreeCache for the given branches of a tree
+ *
+ *  The cache is sized from the average compressed basket size of the 
+ *  branches. The branches are registered explicitly, the learning phase adds
+ *  further branches read during the first entries (e.g. by cut formulas).
+ */
+void ConfigureReadCache(TTree& tree, const std::vector<std::string>& branches) {
+  if (branches.empty()) return;
+
+  Long64_t cache_size = 0;
+  for (std::vector<std::string>::const_iterator it = branches.begin(), end = branches.end();
+       it != end; ++it) {
+    TBranch* branch = tree.GetBranch(it->c_str());
+    if (branch == NULL) continue;
+    cache_size += branch->GetZipBytes()/std::max(1, branch->GetWriteBasket());
   }
-  
-  tree_ = dynamic_cast<TTree*>(file_->Get(tree_name.c_str()));
-  if (tree_ == NULL) {
-    serr << "Tree " << tree_name << " could not be opened properly." << endmsg;
-    throw 2;
+  cache_size = std::min(std::max(cache_size*kCacheBasketsPerBranch, kCacheSizeMin), kCacheSizeMax);
+
+  tree.SetCacheSize(cache_size);
+  tree.SetCacheLearnEntries(kCacheLearnEntries);
+  for (std::vector<std::string>::const_iterator it = branches.begin(), end = branches.end();
+       it != end; ++it) {
+    tree.AddBranchToCache(it->c_str(), true);
   }
-  
-  if (argset.getSize() > 0) tree_->SetBranchStatus("*", 0);
-  
+}
+
+/**
+ *  @brief Get efficiency of the read cache of a tree's current file
+ *
+ *  @return fraction of baskets found in the cache (negative if no cache)
+ */
+double CacheEfficiency(TTree& tree) {
+  TFile* file = tree.GetCurrentFile();
+  if (file == NULL) return -1.0;
+  TTreeCache* cache = dynamic_cast<TTreeCache*>(file->GetCacheRead(tree.GetTree()));
+  return cache != NULL ? cache->GetEfficiency() : -1.0;
+}
+
+/**
+ *  @brief Print read statistics after reading a tree
+ */
+void ReportReadStatistics(Long64_t read_calls, Long64_t bytes_read, double cache_efficiency) {
+  using namespace doocore::io;
+  sinfo << "Read " << bytes_read/(1024.0*1024.0) << " MB in " << read_calls << " read calls";
+  if (cache_efficiency >= 0.0) {
+    sinfo << ", read cache hit rate " << cache_efficiency*100.0 << " %";
+  }
+  sinfo << "." << endmsg;
+}
+
+/**
+ *  @brief Get seconds passed since a given time
+ */
+double SecondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+ *  @brief Get ratio of uncompressed to compressed size of branches in a tree
+ *
+ *  All branches are used if none are given.
+ */
+double CompressionFactor(TTree& tree, const std::vector<std::string>& branches) {
+  Long64_t tot_bytes = 0, zip_bytes = 0;
+  if (branches.empty()) {
+    tot_bytes = tree.GetTotBytes();
+    zip_bytes = tree.GetZipBytes();
+  }
+  for (std::vector<std::string>::const_iterator it = branches.begin(), end = branches.end();
+       it != end; ++it) {
+    TBranch* branch = tree.GetBranch(it->c_str());
+    if (branch == NULL) continue;
+    tot_bytes += branch->GetTotBytes("*");
+    zip_bytes += branch->GetZipBytes("*");
+  }
+  return zip_bytes > 0 ? static_cast<double>(tot_bytes)/zip_bytes : 1.0;
+}
+
+/**
+ *  @brief Add estimated decompressed bytes for bytes read from a tree
+ */
+void AddDecompressedBytes(TTree& tree, const std::vector<std::string>& branches,
+                          Long64_t bytes_read, doocore::io::IOStatistics& statistics) {
+  statistics.bytes_decompressed += static_cast<long long>(bytes_read*CompressionFactor(tree, branches));
+}
+
+/**
+ *  @brief Fill read counters of statistics
+ */
+void AddReadStatistics(TTree& tree, const std::vector<std::string>& branches,
+                       Long64_t read_calls, Long64_t bytes_read,
+                       doocore::io::IOStatistics& statistics) {
+  statistics.read_calls += read_calls;
+  statistics.bytes_read += bytes_read;
+  AddDecompressedBytes(tree, branches, bytes_read, statistics);
+}
+
+/**
+ *  @brief Read counters of a tree's own file
+ *
+ *  For a single file, only reads of this file are counted (not those of 
+ *  other files read concurrently). A TChain closes its files while reading,
+ *  so for chains the process-wide TFile counters are used instead.
+ */
+class TreeReadCounter {
+ public:
+  explicit TreeReadCounter(TTree& tree)
+  : tree_(tree),
+    is_chain_(dynamic_cast<TChain*>(&tree) != NULL),
+    read_calls_start_(ReadCalls()),
+    bytes_read_start_(BytesRead())
+  {}
+
+  Long64_t read_calls() const { return ReadCalls()-read_calls_start_; }
+  Long64_t bytes_read() const { return BytesRead()-bytes_read_start_; }
+
+ private:
+  Long64_t ReadCalls() const {
+    if (is_chain_) return TFile::GetFileReadCalls();
+    return tree_.GetCurrentFile() != NULL ? tree_.GetCurrentFile()->GetReadCalls() : 0;
+  }
+  Long64_t BytesRead() const {
+    if (is_chain_) return TFile::GetFileBytesRead();
+    return tree_.GetCurrentFile() != NULL ? tree_.GetCurrentFile()->GetBytesRead() : 0;
+  }
+
+  TTree&   tree_;
+  bool     is_chain_;
+  Long64_t read_calls_start_;
+  Long64_t bytes_read_start_;
+};
+
+/**
+ *  @brief Select random whole clusters of a tree
+ *
+ *  Each cluster (of each tree in a TChain) is accepted with probability 
+ *  @a fraction using a random generator seeded with @a seed. Entries of 
+ *  accepted clusters are returned in ascending order as global entry numbers.
+ */
+std::vector<Long64_t> SubsampleEntries(TTree& tree, double fraction, unsigned int seed) {
+  std::vector<Long64_t> entries;
+  TRandom3              random(seed);
+  Long64_t              num_entries = tree.GetEntries();
+  entries.reserve(static_cast<std::size_t>(num_entries*fraction*1.1));
+  for (Long64_t offset=0; offset<num_entries; ) {
+    if (tree.LoadTree(offset) < 0) break;
+    TTree*   current         = tree.GetTree();
+    Long64_t current_entries = current->GetEntries();
+    if (current_entries <= 0) break;
+
+    TTree::TClusterIterator clusters = current->GetClusterIterator(0);
+    Long64_t                first_entry;
+    while ((first_entry = clusters()) < current_entries) {
+      Long64_t last_entry = std::min(clusters.GetNextEntry(), current_entries);
+      if (random.Rndm() >= fraction) continue;
+      for (Long64_t entry=first_entry; entry<last_entry && offset+entry<num_entries; ++entry) {
+        entries.push_back(offset+entry);
+      }
+    }
+    offset += current_entries;
+  }
+  return entries;
+}
+
+/**
+ *  @brief Mutex for non-threadsafe setup of ROOT objects in worker threads
+ */
+boost::mutex mutex_import_setup;
+
+/**
+ *  @brief Create import column specification for a RooRealVar or RooCategory
+ *
+ *  @return false if @a arg is neither a RooRealVar nor a RooCategory
+ */
+bool MakeImportColumn(const RooAbsArg& arg, doocore::io::VariableRangeCutting cut_variable_range,
+                      ImportColumn& column) {
+  const RooRealVar*  var = dynamic_cast<const RooRealVar*>(&arg);
+  const RooCategory* cat = dynamic_cast<const RooCategory*>(&arg);
+  if (var == NULL && cat == NULL) return false;
+
+  column.name        = arg.GetName();
+  column.is_category = cat != NULL;
+  column.min         = var != NULL ? var->getMin() : 0.0;
+  column.max         = var != NULL ? var->getMax() : 0.0;
+  // RooFit's import accepts values on the range boundaries
+  column.min_inclusive = var == NULL || !var->hasMin() || cut_variable_range != doocore::io::kCutExclusive;
+  column.max_inclusive = var == NULL || !var->hasMax() || cut_variable_range != doocore::io::kCutExclusive;
+  column.valid_indices.clear();
+  if (cat != NULL) {
+    TIterator*       it_types = cat->typeIterator();
+    const RooCatType* type    = NULL;
+    while ((type = dynamic_cast<const RooCatType*>(it_types->Next()))) {
+      column.valid_indices.insert(type->getVal());
+    }
+    delete it_types;
+  }
+  return true;
+}
+
+/**
+ *  @brief Get columns of a RooArgSet that are available as branches in a tree
+ */
+std::vector<ImportColumn> ImportColumns(const RooArgSet& argset, TTree& tree,
+                                        doocore::io::VariableRangeCutting cut_variable_range) {
+  std::vector<ImportColumn> columns;
   RooLinkedListIter* it  = (RooLinkedListIter*)argset.createIterator();
   RooAbsArg*         arg = NULL;
-  
   while ((arg=(RooAbsArg*)it->Next())) {
-    RooRealVar* var = dynamic_cast<RooRealVar*>(arg);
-    RooCategory* cat = dynamic_cast<RooCategory*>(arg);
-    
-    if (var != NULL || cat != NULL) {
-      if (tree_->GetBranch(arg->GetName()) == NULL) {
-        swarn << "Branch " << arg->GetName() << " not in tree. Ignoring." << endmsg;
+    ImportColumn column;
+    if (tree.GetBranch(arg->GetName()) != NULL && MakeImportColumn(*arg, cut_variable_range, column)) {
+      columns.push_back(column);
+    }
+  }
+  delete it;
+  return columns;
+}
+
+/**
+ *  @brief Apply range cut on a block of values
+ *
+ *  Branch-free comparisons over contiguous values to allow vectorisation.
+ */
+template<bool kMinInclusive, bool kMaxInclusive>
+void ApplyRangeCut(const double* values, double min, double max,
+                   unsigned char* pass, std::size_t size) {
+  for (std::size_t i=0; i<size; ++i) {
+    bool above = kMinInclusive ? values[i] >= min : values[i] > min;
+    bool below = kMaxInclusive ? values[i] <= max : values[i] < max;
+    pass[i] &= static_cast<unsigned char>(above & below);
+  }
+}
+
+/**
+ *  @brief Apply range cut or category state check of a column on a block
+ */
+void ApplyColumnCut(const ImportColumn& column, const double* values,
+                    unsigned char* pass, std::size_t size) {
+  if (column.is_category) {
+    for (std::size_t i=0; i<size; ++i) {
+      if (pass[i] && column.valid_indices.count(static_cast<int>(values[i])) == 0) pass[i] = 0;
+    }
+  } else if (column.min_inclusive && column.max_inclusive) {
+    ApplyRangeCut<true, true>(values, column.min, column.max, pass, size);
+  } else if (column.min_inclusive) {
+    ApplyRangeCut<true, false>(values, column.min, column.max, pass, size);
+  } else if (column.max_inclusive) {
+    ApplyRangeCut<false, true>(values, column.min, column.max, pass, size);
+  } else {
+    ApplyRangeCut<false, false>(values, column.min, column.max, pass, size);
+  }
+}
+
+/**
+ *  @brief User cut evaluated as RooFormula on imported values
+ *
+ *  The cut is evaluated on a copy of the imported variables, i.e. with the 
+ *  same semantics as in RooFit's import: category labels like 
+ *  @c cat==cat::state can be used and only imported variables are known. 
+ *  Throws if the cut cannot be compiled. Evaluation changes the copied 
+ *  variables, so each thread needs its own UserCut.
+ */
+class UserCut {
+ public:
+  UserCut(const RooArgSet& argset, const std::vector<ImportColumn>& columns, const std::string& cut)
+  : vars_(columns.size(), NULL),
+    cats_(columns.size(), NULL)
+  {
+    {
+      boost::mutex::scoped_lock lock(mutex_import_setup);
+      RooArgSet imported;
+      for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+           it != end; ++it) {
+        RooAbsArg* arg = argset.find(it->name.c_str());
+        if (arg != NULL) imported.add(*arg);
+      }
+      row_.reset(dynamic_cast<RooArgSet*>(imported.snapshot(false)));
+      formula_.reset(new RooFormulaVar("user_cut", "user_cut", cut.c_str(), RooArgList(*row_)));
+    }
+    if (!formula_->ok()) {
+      doocore::io::serr << "Cut '" << cut << "' cannot be compiled as RooFormula on the imported variables." << doocore::io::endmsg;
+      throw 6;
+    }
+
+    for (std::size_t i=0; i<columns.size(); ++i) {
+      if (columns[i].is_category) {
+        cats_[i] = dynamic_cast<RooCategory*>(row_->find(columns[i].name.c_str()));
       } else {
-        tree_->SetBranchStatus(arg->GetName(), 1);
+        vars_[i] = dynamic_cast<RooRealVar*>(row_->find(columns[i].name.c_str()));
       }
     }
   }
-  delete it;
+
+  ~UserCut() {
+    boost::mutex::scoped_lock lock(mutex_import_setup);
+    formula_.reset();
+    row_.reset();
+  }
+
+  /**
+   *  @brief Check whether an entry of column buffers passes the cut
+   */
+  bool Passes(const std::vector<std::vector<double> >& values, std::size_t entry) {
+    for (std::size_t i=0; i<vars_.size(); ++i) {
+      if (cats_[i] != NULL) {
+        cats_[i]->setIndex(static_cast<int>(values[i][entry]));
+      } else if (vars_[i] != NULL) {
+        vars_[i]->setVal(values[i][entry]);
+      }
+    }
+    return formula_->getVal() != 0.0;
+  }
+
+ private:
+  std::unique_ptr<RooArgSet>     row_;
+  std::unique_ptr<RooFormulaVar> formula_;
+  std::vector<RooRealVar*>       vars_;
+  std::vector<RooCategory*>      cats_;
+};
+
+/**
+ *  @brief Reader of entry ranges of a tree into column buffers
+ *
+ *  Entries are read in blocks. Variable range cuts and category state checks
+ *  are applied natively column by column on the whole block. Entries with 
+ *  values outside the variable ranges or undefined category states are 
+ *  always skipped as in RooFit's import. An optional user cut is evaluated 
+ *  afterwards on the remaining entries of the block.
+ */
+class BlockImporter {
+ public:
+  BlockImporter(TTree& tree, const std::vector<ImportColumn>& columns,
+                UserCut* user_cut=NULL,
+                const std::function<void(int)>& tree_change_callback=std::function<void(int)>())
+  : columns_(columns),
+    block_(columns.size(), std::vector<double>(kImportBlockSize)),
+    pass_(kImportBlockSize),
+    user_cut_(user_cut)
+  {
+    std::vector<std::string> names;
+    for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+         it != end; ++it) {
+      names.push_back(it->name);
+    }
+    boost::mutex::scoped_lock lock(mutex_import_setup);
+    reader_.reset(new doocore::io::TreeColumnReader(tree, names));
+    reader_->set_tree_change_callback(tree_change_callback);
+  }
+
+  ~BlockImporter() {
+    boost::mutex::scoped_lock lock(mutex_import_setup);
+    reader_.reset();
+  }
+
+  /**
+   *  @brief Import entry range into buffer, replacing previous content
+   *
+   *  The capacity of the buffer is kept so that buffers can be reused. If 
+   *  @a entries is given, the range refers to positions in this list. Entry 
+   *  numbers of accepted entries are appended to @a accepted if given.
+   */
+  void Import(Long64_t first_entry, Long64_t last_entry, 
+              std::vector<std::vector<double> >& buffer, std::size_t& num_entries,
+              const std::vector<Long64_t>* entries=NULL, std::vector<Long64_t>* accepted=NULL) {
+    buffer.resize(columns_.size());
+    for (std::size_t i=0; i<columns_.size(); ++i) {
+      buffer[i].clear();
+    }
+    num_entries = 0;
+
+    for (Long64_t block_first=first_entry; block_first<last_entry; block_first+=kImportBlockSize) {
+      std::size_t block_size = std::min<Long64_t>(kImportBlockSize, last_entry-block_first);
+
+      // timed per block, as timing single entries would be too expensive
+      std::chrono::steady_clock::time_point time_start = std::chrono::steady_clock::now();
+      for (std::size_t j=0; j<block_size; ++j) {
+        Long64_t entry = entries != NULL ? (*entries)[block_first+j] : block_first+j;
+        pass_[j] = reader_->LoadEntry(entry);
+        for (std::size_t i=0; i<columns_.size(); ++i) {
+          block_[i][j] = reader_->Value(i);
+        }
+      }
+      statistics_.time_read += SecondsSince(time_start);
+
+      time_start = std::chrono::steady_clock::now();
+      for (std::size_t i=0; i<columns_.size(); ++i) {
+        ApplyColumnCut(columns_[i], block_[i].data(), pass_.data(), block_size);
+      }
+      if (user_cut_ != NULL) {
+        for (std::size_t j=0; j<block_size; ++j) {
+          if (pass_[j]) pass_[j] = user_cut_->Passes(block_, j);
+        }
+      }
+      statistics_.time_cut        += SecondsSince(time_start);
+      statistics_.entries_scanned += block_size;
+
+      for (std::size_t j=0; j<block_size; ++j) {
+        if (!pass_[j]) continue;
+        for (std::size_t i=0; i<columns_.size(); ++i) {
+          buffer[i].push_back(block_[i][j]);
+        }
+        if (accepted != NULL) accepted->push_back(entries != NULL ? (*entries)[block_first+j] : block_first+j);
+        ++num_entries;
+      }
+    }
+    statistics_.entries_accepted += num_entries;
+    statistics_.read_calls        = reader_->read_calls();
+    statistics_.bytes_read        = reader_->bytes_read();
+  }
+
+  /**
+   *  @brief Entry counts, read counters and read/cut timers of all imports so far
+   */
+  const doocore::io::IOStatistics& statistics() const { return statistics_; }
+
+ private:
+  const std::vector<ImportColumn>&                columns_;
+  std::unique_ptr<doocore::io::TreeColumnReader> reader_;
+  std::vector<std::vector<double> >               block_;
+  std::vector<unsigned char>                      pass_;
+  UserCut*                                        user_cut_;
+  doocore::io::IOStatistics                       statistics_;
+};
+
+/**
+ *  @brief Read an entry range of a tree into an ImportBuffer
+ */
+void ImportEntryRange(TTree& tree, const std::vector<ImportColumn>& columns,
+                      const ImportRange& range, ImportBuffer& buffer,
+                      const std::function<void(int)>& tree_change_callback=std::function<void(int)>()) {
+  BlockImporter importer(tree, columns, NULL, tree_change_callback);
+  buffer.entries.clear();
+  importer.Import(range.first, range.last, buffer.columns, buffer.num_entries,
+                  range.entries, range.record_entries ? &buffer.entries : NULL);
+  buffer.statistics = importer.statistics();
 }
 
-doocore::io::EasyTuple::EasyTuple(TTree* tree, const RooArgSet& argset)
-: file_(NULL),
-tree_(tree),
-argset_(NULL),
-dataset_(NULL),
-num_maximum_events_(-1),
-cut_variable_range_(kCutInclusive)
-{
-  argset_ = new RooArgSet(argset);
-  
-  if (argset.getSize() > 0) tree_->SetBranchStatus("*", 0);
-  
-  RooLinkedListIter* it  = (RooLinkedListIter*)argset.createIterator();
-  RooAbsArg*         arg = NULL;
-  
-  while ((arg=(RooAbsArg*)it->Next())) {
-    RooRealVar* var = dynamic_cast<RooRealVar*>(arg);
-    RooCategory* cat = dynamic_cast<RooCategory*>(arg);
-    
-    if (var != NULL || cat != NULL) {
-      if (tree_->GetBranch(arg->GetName()) == NULL) {
-        swarn << "Branch " << arg->GetName() << " not in tree. Ignoring." << endmsg;
+/**
+ *  @brief Expand shell wildcards in file names
+ *
+ *  Names without wildcards are kept as they are (they might be remote URLs).
+ *  Matches of each pattern are sorted, the order of patterns is kept.
+ */
+std::vector<std::string> ExpandFileNames(const std::vector<std::string>& patterns) {
+  std::vector<std::string> file_names;
+  for (std::vector<std::string>::const_iterator it = patterns.begin(), end = patterns.end();
+       it != end; ++it) {
+    if (it->find_first_of("*?[") == std::string::npos) {
+      file_names.push_back(*it);
+      continue;
+    }
+
+    glob_t matches;
+    if (glob(it->c_str(), 0, NULL, &matches) == 0) {
+      std::vector<std::string> expanded(matches.gl_pathv, matches.gl_pathv+matches.gl_pathc);
+      std::sort(expanded.begin(), expanded.end());
+      file_names.insert(file_names.end(), expanded.begin(), expanded.end());
+    } else {
+      doocore::io::swarn << "No files matching " << *it << ". Ignoring." << doocore::io::endmsg;
+    }
+    globfree(&matches);
+  }
+  return file_names;
+}
+
+/**
+ *  @brief Open TFile and TTree (or TChain for more than one file) for a worker
+ *
+ *  The same branches as in the EasyTuple are activated. Returns NULL if the
+ *  tree cannot be opened, file and chain have to be closed via 
+ *  CloseWorkerTree() in any case.
+ */
+TTree* OpenWorkerTree(const std::vector<std::string>& file_names, const std::string& tree_name,
+                      const std::vector<std::string>& active_branches,
+                      TFile*& file, TChain*& chain) {
+  TTree* tree = NULL;
+  boost::mutex::scoped_lock lock(mutex_import_setup);
+  if (file_names.size() == 1) {
+    file = new TFile(file_names.front().c_str());
+    if (!file->IsZombie()) tree = dynamic_cast<TTree*>(file->Get(tree_name.c_str()));
+  } else {
+    chain = new TChain(tree_name.c_str());
+    for (std::vector<std::string>::const_iterator it = file_names.begin(), end = file_names.end();
+         it != end; ++it) {
+      chain->Add(it->c_str());
+    }
+    tree = chain;
+  }
+  if (tree != NULL && active_branches.size() > 0) {
+    tree->SetBranchStatus("*", 0);
+    for (std::vector<std::string>::const_iterator it = active_branches.begin(), end = active_branches.end();
+         it != end; ++it) {
+      tree->SetBranchStatus(it->c_str(), 1);
+    }
+    ConfigureReadCache(*tree, active_branches);
+  }
+  return tree;
+}
+
+/**
+ *  @brief Delete TFile and TChain opened by OpenWorkerTree()
+ */
+void CloseWorkerTree(TFile* file, TChain* chain) {
+  boost::mutex::scoped_lock lock(mutex_import_setup);
+  if (chain != NULL) delete chain;
+  if (file != NULL) delete file;
+}
+
+/**
+ *  @brief Worker for parallel conversion opening its own TFile and TTree
+ *
+ *  For more than one file, a TChain over all files is opened instead so that
+ *  entry ranges refer to global entry numbers of the chain.
+ */
+void ImportWorker(const std::vector<std::string>& file_names, const std::string& tree_name,
+                  const std::vector<std::string>& active_branches,
+                  const std::vector<ImportColumn>& columns,
+                  const ImportRange& range, ImportBuffer* buffer) {
+  using namespace doocore::io;
+  TFile*  file  = NULL;
+  TChain* chain = NULL;
+  try {
+    TTree* tree = OpenWorkerTree(file_names, tree_name, active_branches, file, chain);
+    if (tree != NULL) {
+      ImportEntryRange(*tree, columns, range, *buffer);
+      buffer->cache_efficiency = CacheEfficiency(*tree);
+      buffer->success = true;
+    } else {
+      serr << "Tree " << tree_name << " in file " << file_names.front() << " could not be opened by worker thread." << endmsg;
+    }
+  } catch (...) {
+    buffer->success = false;
+  }
+  CloseWorkerTree(file, chain);
+}
+
+/**
+ *  @brief Binning of one dimension of a histogram over import columns
+ */
+struct HistogramAxis {
+  bool                 is_category;
+  int                  num_bins;
+  double               min;
+  double               max;
+  /// whether bins are equidistant (otherwise boundaries are used)
+  bool                 uniform;
+  std::vector<double>  boundaries;
+  /// bin number per category index
+  std::map<int, int>   category_bins;
+  /// category index per bin number
+  std::vector<int>     category_indices;
+  /// distance between neighbouring bins of this axis in the bin array
+  std::size_t          stride;
+};
+
+/**
+ *  @brief Get histogram axes for import columns from variable binnings
+ *
+ *  Real variables use their default binning, categories one bin per state.
+ */
+std::vector<HistogramAxis> HistogramAxes(const RooArgSet& argset, const std::vector<ImportColumn>& columns) {
+  std::vector<HistogramAxis> axes(columns.size());
+  std::size_t                stride = 1;
+  for (std::size_t i=0; i<columns.size(); ++i) {
+    HistogramAxis& axis = axes[i];
+    axis.is_category = columns[i].is_category;
+    if (axis.is_category) {
+      int bin = 0;
+      for (std::set<int>::const_iterator it = columns[i].valid_indices.begin(), end = columns[i].valid_indices.end();
+           it != end; ++it) {
+        axis.category_bins[*it] = bin++;
+        axis.category_indices.push_back(*it);
+      }
+      axis.num_bins = bin;
+    } else {
+      const RooAbsBinning& binning = dynamic_cast<RooRealVar*>(argset.find(columns[i].name.c_str()))->getBinning();
+      if (!std::isfinite(binning.lowBound()) || !std::isfinite(binning.highBound()) || binning.numBins() <= 0) {
+        doocore::io::serr << "Variable " << columns[i].name << " has no finite range to bin. Cannot fill RooDataHist." << doocore::io::endmsg;
+        throw 12;
+      }
+      axis.num_bins = binning.numBins();
+      axis.min      = binning.lowBound();
+      axis.max      = binning.highBound();
+      axis.uniform  = binning.isUniform();
+      axis.boundaries.assign(binning.array(), binning.array()+binning.numBoundaries());
+    }
+    axis.stride = stride;
+    stride     *= std::max(1, axis.num_bins);
+  }
+  return axes;
+}
+
+/**
+ *  @brief Get number of bins of a histogram over all axes
+ */
+std::size_t NumHistogramBins(const std::vector<HistogramAxis>& axes) {
+  std::size_t num_bins = 1;
+  for (std::vector<HistogramAxis>::const_iterator it = axes.begin(), end = axes.end();
+       it != end; ++it) {
+    num_bins *= std::max(1, it->num_bins);
+  }
+  return num_bins;
+}
+
+/**
+ *  @brief Add entries of column buffers to bin counts
+ *
+ *  Values are expected to be inside the axis ranges (i.e. range cuts are 
+ *  applied), values on the upper boundary go into the last bin. Entries with
+ *  non-finite values are skipped.
+ */
+void FillBinCounts(const std::vector<HistogramAxis>& axes, const std::vector<std::vector<double> >& columns,
+                   std::size_t num_entries, std::vector<double>& counts) {
+  std::vector<std::size_t>   bins(num_entries, 0);
+  std::vector<unsigned char> finite(num_entries, 1);
+  for (std::size_t i=0; i<axes.size(); ++i) {
+    const HistogramAxis& axis   = axes[i];
+    const double*        values = columns[i].data();
+    if (axis.is_category) {
+      for (std::size_t j=0; j<num_entries; ++j) {
+        std::map<int, int>::const_iterator it = axis.category_bins.find(static_cast<int>(values[j]));
+        bins[j] += axis.stride*(it != axis.category_bins.end() ? it->second : 0);
+      }
+    } else if (axis.uniform) {
+      double scale = axis.num_bins/(axis.max-axis.min);
+      for (std::size_t j=0; j<num_entries; ++j) {
+        if (!std::isfinite(values[j])) {
+          finite[j] = 0;
+          continue;
+        }
+        int bin = static_cast<int>((values[j]-axis.min)*scale);
+        bin     = std::min(std::max(bin, 0), axis.num_bins-1);
+        bins[j] += axis.stride*bin;
+      }
+    } else {
+      for (std::size_t j=0; j<num_entries; ++j) {
+        if (!std::isfinite(values[j])) {
+          finite[j] = 0;
+          continue;
+        }
+        int bin = std::upper_bound(axis.boundaries.begin(), axis.boundaries.end(), values[j]) - axis.boundaries.begin() - 1;
+        bin     = std::min(std::max(bin, 0), axis.num_bins-1);
+        bins[j] += axis.stride*bin;
+      }
+    }
+  }
+  for (std::size_t j=0; j<num_entries; ++j) {
+    if (finite[j]) counts[bins[j]] += 1.0;
+  }
+}
+
+/**
+ *  @brief Worker for parallel histogram filling opening its own TFile and TTree
+ *
+ *  The entry range is read in chunks and added to the worker's bin counts.
+ *  The user cut (NULL if none) is used by this worker only.
+ */
+void HistogramWorker(const std::vector<std::string>& file_names, const std::string& tree_name,
+                     const std::vector<std::string>& active_branches,
+                     const std::vector<ImportColumn>& columns,
+                     const std::vector<HistogramAxis>& axes,
+                     UserCut* user_cut, const ImportRange& range,
+                     std::vector<double>* counts, doocore::io::IOStatistics* statistics, bool* success) {
+  TFile*  file  = NULL;
+  TChain* chain = NULL;
+  *success = false;
+  try {
+    TTree* tree = OpenWorkerTree(file_names, tree_name, active_branches, file, chain);
+    if (tree != NULL) {
+      BlockImporter                     importer(*tree, columns, user_cut);
+      std::vector<std::vector<double> > buffer;
+      std::size_t                       num_entries = 0;
+      for (Long64_t first_entry=range.first; first_entry<range.last; first_entry+=kHistogramChunkSize) {
+        importer.Import(first_entry, std::min<Long64_t>(first_entry+kHistogramChunkSize, range.last),
+                        buffer, num_entries, range.entries);
+        FillBinCounts(axes, buffer, num_entries, *counts);
+      }
+      *statistics = importer.statistics();
+      *success    = true;
+    }
+  } catch (...) {
+    *success = false;
+  }
+  CloseWorkerTree(file, chain);
+}
+
+/**
+ *  @brief Batch of dataset entries for asynchronous tree writing
+ *
+ *  Values are stored entry by entry, i.e. all reals (and categories) of one 
+ *  entry are adjacent.
+ */
+struct WriteBatch {
+  WriteBatch() : num_entries(0) {}
+  std::vector<double> reals;
+  std::vector<int>    cats;
+  std::vector<double> weights;
+  std::size_t         num_entries;
+};
+
+/**
+ *  @brief Formula variable evaluated natively as additional buffer column
+ */
+struct FormulaColumn {
+  const RooFormulaVar*                        formula;
+  std::shared_ptr<doocore::io::FormulaKernel> kernel;
+  /// buffer column per kernel input (negative for constant inputs)
+  std::vector<int>                            input_columns;
+  /// values of constant inputs
+  std::vector<double>                         constants;
+  /// buffer column for the results
+  std::size_t                                 output_column;
+};
+
+/**
+ *  @brief Compile formula variables into kernels on import columns
+ *
+ *  Formulas whose dependents are all import columns, earlier compiled 
+ *  formulas or constant variables are removed from @a formulas and appended 
+ *  to @a columns. The remaining formulas have to be added via 
+ *  RooDataSet::addColumn().
+ */
+std::vector<FormulaColumn> CompileFormulaColumns(std::vector<RooFormulaVar*>& formulas,
+                                                 std::vector<ImportColumn>& columns) {
+  std::vector<FormulaColumn>  formula_columns;
+  std::vector<RooFormulaVar*> remaining;
+  for (std::vector<RooFormulaVar*>::const_iterator it = formulas.begin(), end = formulas.end();
+       it != end; ++it) {
+    FormulaColumn formula_column;
+    formula_column.formula = *it;
+    formula_column.kernel = std::make_shared<doocore::io::FormulaKernel>(**it);
+    bool native = formula_column.kernel->IsCompiled();
+    for (int k=0; native && (*it)->getParameter(k) != NULL; ++k) {
+      RooAbsArg* dependent = (*it)->getParameter(k);
+      int        index     = -1;
+      for (std::size_t i=0; i<columns.size() && index<0; ++i) {
+        if (columns[i].name == dependent->GetName()) index = i;
+      }
+      RooAbsReal* constant = dynamic_cast<RooRealVar*>(dependent) != NULL ||
+                             dynamic_cast<RooConstVar*>(dependent) != NULL 
+                             ? dynamic_cast<RooAbsReal*>(dependent) : NULL;
+      if (index < 0 && constant == NULL) native = false;
+      formula_column.input_columns.push_back(index);
+      formula_column.constants.push_back(index < 0 && constant != NULL ? constant->getVal() : 0.0);
+    }
+    if (!native) {
+      remaining.push_back(*it);
+      continue;
+    }
+
+    ImportColumn column;
+    column.name        = (*it)->GetName();
+    column.is_category = false;
+    formula_column.output_column = columns.size();
+    columns.push_back(column);
+    formula_columns.push_back(formula_column);
+  }
+  formulas.swap(remaining);
+  return formula_columns;
+}
+
+/**
+ *  @brief Evaluate compiled formulas on an entry range of a buffer
+ *
+ *  Output columns have to be sized already.
+ */
+void EvaluateFormulaRange(const std::vector<FormulaColumn>* formula_columns, ImportBuffer* buffer,
+                          std::size_t first_entry, std::size_t last_entry) {
+  std::size_t                       num_entries = last_entry-first_entry;
+  std::vector<const double*>        inputs;
+  std::vector<std::vector<double> > constants;
+  for (std::vector<FormulaColumn>::const_iterator it = formula_columns->begin(), end = formula_columns->end();
+       it != end; ++it) {
+    inputs.clear();
+    constants.assign(it->input_columns.size(), std::vector<double>());
+    for (std::size_t k=0; k<it->input_columns.size(); ++k) {
+      if (it->input_columns[k] >= 0) {
+        inputs.push_back(buffer->columns[it->input_columns[k]].data()+first_entry);
       } else {
-        tree_->SetBranchStatus(arg->GetName(), 1);
+        constants[k].assign(num_entries, it->constants[k]);
+        inputs.push_back(constants[k].data());
       }
     }
+    it->kernel->Evaluate(inputs, buffer->columns[it->output_column].data()+first_entry, num_entries);
   }
-  delete it;
+}
+
+/**
+ *  @brief Evaluate compiled formulas on all buffers
+ *
+ *  Buffers are split into entry ranges evaluated on up to num_threads threads.
+ */
+void EvaluateFormulaColumns(const std::vector<FormulaColumn>& formula_columns,
+                            std::vector<ImportBuffer>& buffers, int num_threads) {
+  if (formula_columns.empty()) return;
+  for (std::vector<ImportBuffer>::iterator it = buffers.begin(), end = buffers.end();
+       it != end; ++it) {
+    for (std::vector<FormulaColumn>::const_iterator it_formula = formula_columns.begin(), end_formula = formula_columns.end();
+         it_formula != end_formula; ++it_formula) {
+      it->columns.push_back(std::vector<double>(it->num_entries));
+    }
+  }
+
+  if (num_threads <= 1) {
+    for (std::vector<ImportBuffer>::iterator it = buffers.begin(), end = buffers.end();
+         it != end; ++it) {
+      EvaluateFormulaRange(&formula_columns, &(*it), 0, it->num_entries);
+    }
+    return;
+  }
+
+  int num_ranges = std::max<int>(1, num_threads/buffers.size());
+  boost::thread_group threads;
+  for (std::vector<ImportBuffer>::iterator it = buffers.begin(), end = buffers.end();
+       it != end; ++it) {
+    for (int i=0; i<num_ranges; ++i) {
+      threads.create_thread(boost::bind(&EvaluateFormulaRange, &formula_columns, &(*it),
+                                        it->num_entries*i/num_ranges, it->num_entries*(i+1)/num_ranges));
+    }
+  }
+  threads.join_all();
+}
+
+/**
+ *  @brief Apply a RooFit cut string on imported entries, compacting the buffers
+ *
+ *  The cut is evaluated as RooFormula on a copy of the imported variables, 
+ *  i.e. with the same semantics as in RooFit's import. Recorded entry 
+ *  numbers are compacted alongside. Throws if the cut cannot be compiled.
+ */
+void ApplyUserCut(const RooArgSet& argset, const std::vector<ImportColumn>& columns,
+                  const std::string& cut, std::vector<ImportBuffer>& buffers) {
+  UserCut user_cut(argset, columns, cut);
+  for (std::vector<ImportBuffer>::iterator it = buffers.begin(), end = buffers.end();
+       it != end; ++it) {
+    std::chrono::steady_clock::time_point time_start = std::chrono::steady_clock::now();
+    bool        has_entries = !it->entries.empty();
+    std::size_t num_kept    = 0;
+    for (std::size_t entry=0; entry<it->num_entries; ++entry) {
+      if (!user_cut.Passes(it->columns, entry)) continue;
+
+      if (num_kept != entry) {
+        for (std::size_t i=0; i<columns.size(); ++i) {
+          it->columns[i][num_kept] = it->columns[i][entry];
+        }
+        if (has_entries) it->entries[num_kept] = it->entries[entry];
+      }
+      ++num_kept;
+    }
+    for (std::size_t i=0; i<columns.size(); ++i) {
+      it->columns[i].resize(num_kept);
+    }
+    if (has_entries) it->entries.resize(num_kept);
+    it->statistics.entries_accepted -= it->num_entries-num_kept;
+    it->statistics.time_cut         += SecondsSince(time_start);
+    it->num_entries = num_kept;
+  }
+}
+
+/**
+ *  @brief Fill ImportBuffers into a new RooDataSet in order
+ */
+RooDataSet* FillDataSet(const RooArgSet& argset, const std::vector<ImportColumn>& columns,
+                        const std::vector<ImportBuffer>& buffers) {
+  RooDataSet*      dataset = new RooDataSet("dataset","dataset",argset);
+  const RooArgSet* row     = dataset->get();
+
+  std::vector<RooRealVar*>  vars(columns.size(), NULL);
+  std::vector<RooCategory*> cats(columns.size(), NULL);
+  for (std::size_t i=0; i<columns.size(); ++i) {
+    if (columns[i].is_category) {
+      cats[i] = dynamic_cast<RooCategory*>(row->find(columns[i].name.c_str()));
+    } else {
+      vars[i] = dynamic_cast<RooRealVar*>(row->find(columns[i].name.c_str()));
+    }
+  }
+
+  for (std::vector<ImportBuffer>::const_iterator it = buffers.begin(), end = buffers.end();
+       it != end; ++it) {
+    for (std::size_t entry=0; entry<it->num_entries; ++entry) {
+      for (std::size_t i=0; i<columns.size(); ++i) {
+        if (cats[i] != NULL) {
+          cats[i]->setIndex(static_cast<int>(it->columns[i][entry]));
+        } else {
+          vars[i]->setVal(it->columns[i][entry]);
+        }
+      }
+      dataset->add(*row);
+    }
+  }
+  return dataset;
+}
+
+/**
+ *  @brief Append the defined states of a category to a cache key
+ */
+void AppendCategoryStates(const RooCategory& cat, std::stringstream& key) {
+  key << cat.GetName() << "{";
+  TIterator*        it_types = cat.typeIterator();
+  const RooCatType* type     = NULL;
+  while ((type = dynamic_cast<const RooCatType*>(it_types->Next()))) {
+    key << type->GetName() << "=" << type->getVal() << ",";
+  }
+  delete it_types;
+  key << "}";
+}
+} // namespace
+
+doocore::io::EasyTuple::EasyTuple(const std::string& file_name, const std::string& tree_name, const RooArgSet& argset)
+: tree_(NULL),
+  argset_(new RooArgSet(argset)),
+  tree_name_(tree_name),
+  num_maximum_events_(-1),
+  cut_variable_range_(kCutInclusive),
+  num_threads_(1),
+  subsample_fraction_(1.0),
+  subsample_seed_(0),
+  file_names_(1, file_name)
+{
+  OpenFile();
+  ActivateBranches();
+}
+
+doocore::io::EasyTuple::EasyTuple(const std::vector<std::string>& file_names, const std::string& tree_name, const RooArgSet& argset)
+: tree_(NULL),
+  argset_(new RooArgSet(argset)),
+  tree_name_(tree_name),
+  num_maximum_events_(-1),
+  cut_variable_range_(kCutInclusive),
+  num_threads_(1),
+  subsample_fraction_(1.0),
+  subsample_seed_(0),
+  file_names_(ExpandFileNames(file_names))
+{
+  if (file_names_.empty()) {
+    serr << "No files to chain for tree " << tree_name << "." << endmsg;
+    throw 1;
+  }
+
+  OpenChain();
+  ActivateBranches();
+}
+
+doocore::io::EasyTuple::EasyTuple(TTree* tree, const RooArgSet& argset)
+: tree_(tree),
+argset_(new RooArgSet(argset)),
+num_maximum_events_(-1),
+cut_variable_range_(kCutInclusive),
+num_threads_(1),
+subsample_fraction_(1.0),
+subsample_seed_(0)
+{
+  ActivateBranches();
 }
 
 doocore::io::EasyTuple::EasyTuple(RooDataSet& dataset, const RooArgSet& argset)
-: file_(NULL),
-tree_(NULL),
-argset_(NULL),
+: tree_(NULL),
 dataset_(&dataset),
 num_maximum_events_(-1),
-cut_variable_range_(kCutInclusive)
+cut_variable_range_(kCutInclusive),
+num_threads_(1),
+subsample_fraction_(1.0),
+subsample_seed_(0)
 {
   if (argset.getSize() > 0) {
-    argset_ = new RooArgSet(argset);
+    argset_.reset(new RooArgSet(argset));
   } else {
-    argset_ = new RooArgSet(*dataset_->get());
+    argset_.reset(new RooArgSet(*dataset_->get()));
   }
 }
 
-doocore::io::EasyTuple::EasyTuple(const EasyTuple& other)
-: file_(NULL),
-tree_(NULL),
-argset_(NULL),
-dataset_(NULL),
-tree_name_(other.tree_name_),
-num_maximum_events_(other.num_maximum_events_),
-cut_variable_range_(other.cut_variable_range_)
-{
-  argset_ = new RooArgSet(*other.argset_);
-  
-  if (other.file_ == NULL) {
-    tree_ = other.tree_;
-  } else {
-    file_ = new TFile(other.file_->GetName());
-    
-    if (file_ == NULL || file_->IsZombie() || file_->GetNkeys() <= 0) {
-      serr << "File could not be opened properly." << endmsg;
-      throw 1;
-    }
-    
-    tree_ = dynamic_cast<TTree*>(file_->Get(tree_name_.c_str()));
-    if (tree_ == NULL) {
-      serr << "Tree " << tree_name_ << " could not be opened properly." << endmsg;
-      throw 2;
-    }
-    
-    if (argset_->getSize() > 0) tree_->SetBranchStatus("*", 0);
-    
-    RooLinkedListIter* it  = (RooLinkedListIter*)argset_->createIterator();
+doocore::io::EasyTuple::EasyTuple(const EasyTuple& other)
+: tree_(NULL),
+argset_(new RooArgSet(*other.argset_)),
+dataset_(other.dataset_),
+compact_store_(other.compact_store_),
+datahist_(other.datahist_),
+tree_name_(other.tree_name_),
+num_maximum_events_(other.num_maximum_events_),
+cut_variable_range_(other.cut_variable_range_),
+cache_directory_(other.cache_directory_),
+entry_list_directory_(other.entry_list_directory_),
+num_threads_(other.num_threads_),
+subsample_fraction_(other.subsample_fraction_),
+subsample_seed_(other.subsample_seed_),
+active_branches_(other.active_branches_),
+file_names_(other.file_names_),
+io_statistics_(other.io_statistics_)
+{
+  // the converted dataset is shared, only the tree is opened again
+  if (other.chain_ == nullptr && other.file_ == nullptr) {
+    tree_ = other.tree_;
+  } else {
+    if (other.chain_ != nullptr) {
+      OpenChain();
+    } else {
+      OpenFile();
+    }
+    ActivateBranches();
+
+    if (num_maximum_events_>=0) {
+      set_num_maximum_events(num_maximum_events_);
+    }
+  }
+}
+
+doocore::io::EasyTuple::EasyTuple(EasyTuple&& other)
+: file_(std::move(other.file_)),
+chain_(std::move(other.chain_)),
+tree_(other.tree_),
+argset_(std::move(other.argset_)),
+dataset_(std::move(other.dataset_)),
+compact_store_(std::move(other.compact_store_)),
+datahist_(std::move(other.datahist_)),
+tree_name_(std::move(other.tree_name_)),
+num_maximum_events_(other.num_maximum_events_),
+cut_variable_range_(other.cut_variable_range_),
+cache_directory_(std::move(other.cache_directory_)),
+entry_list_directory_(std::move(other.entry_list_directory_)),
+num_threads_(other.num_threads_),
+subsample_fraction_(other.subsample_fraction_),
+subsample_seed_(other.subsample_seed_),
+active_branches_(std::move(other.active_branches_)),
+file_names_(std::move(other.file_names_)),
+io_statistics_(other.io_statistics_)
+{
+  other.tree_ = NULL;
+}
+
+doocore::io::EasyTuple& doocore::io::EasyTuple::operator=(const EasyTuple& other) {
+  if (this != &other) {
+    EasyTuple copy(other);
+    *this = std::move(copy);
+  }
+  return *this;
+}
+
+doocore::io::EasyTuple& doocore::io::EasyTuple::operator=(EasyTuple&& other) {
+  if (this != &other) {
+    CloseTree();
+
+    file_                 = std::move(other.file_);
+    chain_                = std::move(other.chain_);
+    tree_                 = other.tree_;
+    other.tree_           = NULL;
+    argset_               = std::move(other.argset_);
+    dataset_              = std::move(other.dataset_);
+    compact_store_        = std::move(other.compact_store_);
+    datahist_             = std::move(other.datahist_);
+    tree_name_            = std::move(other.tree_name_);
+    num_maximum_events_   = other.num_maximum_events_;
+    cut_variable_range_   = other.cut_variable_range_;
+    cache_directory_      = std::move(other.cache_directory_);
+    entry_list_directory_ = std::move(other.entry_list_directory_);
+    num_threads_          = other.num_threads_;
+    subsample_fraction_   = other.subsample_fraction_;
+    subsample_seed_       = other.subsample_seed_;
+    active_branches_      = std::move(other.active_branches_);
+    file_names_           = std::move(other.file_names_);
+    io_statistics_        = other.io_statistics_;
+  }
+  return *this;
+}
+
+doocore::io::EasyTuple::~EasyTuple() {
+  CloseTree();
+}
+
+doocore::io::EasyTuple doocore::io::EasyTuple::FromTextFile(const std::string& file_name, const RooArgSet& argset,
+                                                            const std::vector<std::string>& column_names,
+                                                            int num_threads) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  TextFileParser parser(file_name);
+
+  std::vector<std::string> names = column_names.empty() ? parser.header() : column_names;
+  if (names.empty()) {
+    RooLinkedListIter* it  = (RooLinkedListIter*)argset.createIterator();
     RooAbsArg*         arg = NULL;
-    
     while ((arg=(RooAbsArg*)it->Next())) {
-      RooRealVar* var = dynamic_cast<RooRealVar*>(arg);
-      RooCategory* cat = dynamic_cast<RooCategory*>(arg);
-      
-      if (var != NULL || cat != NULL) {
-        if (tree_->GetBranch(arg->GetName()) == NULL) {
-          swarn << "Branch " << arg->GetName() << " not in tree. Ignoring." << endmsg;
-        } else {
-          tree_->SetBranchStatus(arg->GetName(), 1);
-        }
-      }
+      names.push_back(arg->GetName());
     }
     delete it;
+  }
 
-    if (num_maximum_events_>=0) {
-      set_num_maximum_events(num_maximum_events_);
+  // file columns to import
+  std::vector<ImportColumn> columns;
+  std::vector<std::size_t>  file_columns;
+  RooArgSet                 import_set;
+  for (std::size_t i=0; i<names.size(); ++i) {
+    RooAbsArg*   arg = argset.find(names[i].c_str());
+    ImportColumn column;
+    if (arg != NULL && MakeImportColumn(*arg, kCutInclusive, column)) {
+      columns.push_back(column);
+      file_columns.push_back(i);
+      import_set.add(*arg);
     }
-    
-    if (other.dataset_ != NULL) {
-      dataset_ = new RooDataSet(*other.dataset_);
+  }
+  if (columns.empty()) {
+    serr << "No columns of " << file_name << " match the variables to import." << endmsg;
+    throw 11;
+  }
+
+  std::vector<std::vector<double> > values;
+  std::size_t num_lines = parser.Parse(names.size(), num_threads, values);
+
+  std::vector<unsigned char> pass(num_lines, 1);
+  for (std::size_t k=0; k<columns.size(); ++k) {
+    ApplyColumnCut(columns[k], values[file_columns[k]].data(), pass.data(), num_lines);
+  }
+
+  std::vector<ImportBuffer> buffers(1);
+  ImportBuffer&             buffer = buffers.front();
+  buffer.columns.resize(columns.size());
+  for (std::size_t k=0; k<columns.size(); ++k) {
+    const std::vector<double>& column_values = values[file_columns[k]];
+    std::vector<double>&       accepted      = buffer.columns[k];
+    accepted.reserve(num_lines);
+    for (std::size_t i=0; i<num_lines; ++i) {
+      if (pass[i]) accepted.push_back(column_values[i]);
     }
+    std::vector<double>().swap(values[file_columns[k]]);
   }
+  buffer.num_entries = columns.empty() ? 0 : buffer.columns[0].size();
+
+  RooDataSet* dataset = FillDataSet(import_set, columns, buffers);
+  sinfo << "Read " << num_lines << " lines from " << file_name << " with " << std::max(1, num_threads)
+        << " threads, " << buffer.num_entries << " entries accepted (" << SecondsSince(start) << " s)." << endmsg;
+  return EasyTuple(*dataset, argset);
 }
 
-doocore::io::EasyTuple::~EasyTuple() {
-  if (dataset_ != NULL) delete dataset_;
-  if (argset_ != NULL) delete argset_;
-  if (tree_ != NULL && file_!= NULL) delete tree_;
-  if (file_ != NULL) delete file_;
+RooDataSet& doocore::io::EasyTuple::dataset() {
+  DetachDataSet();
+  return *dataset_;
 }
 
 RooDataSet& doocore::io::EasyTuple::ConvertToDataSet(const RooCmdArg& arg1,
@@ -189,7 +1281,7 @@ RooDataSet& doocore::io::EasyTuple::ConvertToDataSet(const RooCmdArg& arg1,
                                                      const RooCmdArg& arg5,
                                                      const RooCmdArg& arg6,
                                                      const RooCmdArg& arg7) {
-  if (argset_ == NULL) {
+  if (argset_ == nullptr) {
     serr << "Internal argset not set. Cannot convert to RooDataSet without this." << endmsg;
     throw 4;
   }
@@ -205,7 +1297,7 @@ RooDataSet& doocore::io::EasyTuple::ConvertToDataSet(const RooArgSet& argset,
                                                      const RooCmdArg& arg5,
                                                      const RooCmdArg& arg6,
                                                      const RooCmdArg& arg7) {
-  if (dataset_ != NULL) {
+  if (dataset_ != nullptr) {
     serr << "Dataset was converted before. Maybe you want to use doocore::io::EasyTuple::dataset()." << endmsg;
     throw 3;
   }
@@ -243,13 +1335,16 @@ RooDataSet& doocore::io::EasyTuple::ConvertToDataSet(const RooArgSet& argset,
   std::vector<RooCmdArg> args;
   args += arg1, arg2, arg3, arg4, arg5, arg6, arg7;
   
+  std::string user_cut_string;
   bool found_cut_arg = false;
+  bool found_other_arg = false;
   for (std::vector<RooCmdArg>::iterator it=args.begin(), end=args.end();
        it != end; ++it) {
     std::string name = it->GetName();
+    if (name != "" && name != "CutSpec") found_other_arg = true;
     if (name == "CutSpec") {
       if ((void*)it->getString(0) != NULL) {
-        std::string user_cut_string(it->getString(0));
+        user_cut_string = it->getString(0);
         if (user_cut_string.length() > 0) stream_cut_variables << "&&" << user_cut_string;
       }
       cut_variables = stream_cut_variables.str();
@@ -278,89 +1373,799 @@ RooDataSet& doocore::io::EasyTuple::ConvertToDataSet(const RooArgSet& argset,
   //temp: copy tree 
   //tree_ = tree_->CopyTree("", "", 800000);
   //tree_->SetEntries(300000);
+
+  std::string snapshot_key;
+  if (cache_directory_.length() > 0) {
+    if (found_other_arg) {
+      sinfo << "doocore::io::EasyTuple::ConvertToDataSet(...): Additional RooCmdArgs passed, snapshot cache will not be used." << endmsg;
+    } else {
+      snapshot_key = SnapshotKey(argset, cut_variables);
+    }
+  }
+  if (snapshot_key.length() > 0) {
+    SnapshotCache cache(cache_directory_);
+    dataset_.reset(cache.Load(snapshot_key, new_set));
+    if (dataset_ != nullptr) {
+      sinfo << "Loaded dataset with " << dataset_->numEntries() << " entries from snapshot " << cache.FileName(snapshot_key) << endmsg;
+      return *dataset_;
+    }
+  }
  
-  dataset_ = new RooDataSet("dataset","dataset",new_set,Import(*tree_), args[0],
-                            args[1], args[2], args[3], args[4], args[5], args[6]);
+  IOStatistics                          statistics;
+  std::chrono::steady_clock::time_point time_start = std::chrono::steady_clock::now();
+  if (!found_other_arg) {
+    std::string entry_list_key;
+    if (entry_list_directory_.length() > 0) {
+      entry_list_key = EntryListKey(new_set, cut_variables);
+    }
+    dataset_.reset(ConvertNative(new_set, user_cut_string, entry_list_key, statistics, formulas));
+  } else {
+    if (num_threads_ > 1) {
+      sinfo << "doocore::io::EasyTuple::ConvertToDataSet(...): Parallel conversion needs no RooCmdArgs besides Cut(). Converting on one thread." << endmsg;
+    }
+    if (subsample_fraction_ < 1.0) {
+      swarn << "doocore::io::EasyTuple::ConvertToDataSet(...): Subsampling needs no RooCmdArgs besides Cut(). Converting all entries." << endmsg;
+    }
+    TreeReadCounter read_counter(*tree_);
+    dataset_.reset(new RooDataSet("dataset","dataset",new_set,Import(*tree_), args[0],
+                                  args[1], args[2], args[3], args[4], args[5], args[6]));
+    ReportReadStatistics(read_counter.read_calls(), read_counter.bytes_read(), CacheEfficiency(*tree_));
+
+    // RooFit's import does not allow to separate reading, cuts and insertion
+    AddReadStatistics(*tree_, active_branches_, read_counter.read_calls(),
+                      read_counter.bytes_read(), statistics);
+    statistics.entries_scanned  = tree_->GetEntries();
+    statistics.entries_accepted = dataset_->numEntries();
+  }
   
+  // remaining formulas (all for RooFit's import) are evaluated event by event
+  std::chrono::steady_clock::time_point time_add_column_start = std::chrono::steady_clock::now();
   for (std::vector<RooFormulaVar*>::const_iterator it = formulas.begin();
        it != formulas.end(); ++it) {
     sinfo << "Adding formula " << (*it)->GetName() << " to dataset." << endmsg;
     dataset_->addColumn(**it);
   }
+  statistics.time_add_column += SecondsSince(time_add_column_start);
+  statistics.time_total      = SecondsSince(time_start);
+  io_statistics_ += statistics;
+  PublishIOStatistics("EasyTuple::ConvertToDataSet", statistics);
+
+  if (snapshot_key.length() > 0) {
+    SnapshotCache(cache_directory_).Save(snapshot_key, *dataset_);
+  }
   
   return *dataset_;
 }
 
-void doocore::io::EasyTuple::WriteDataSetToTree(const std::string& file_name, const std::string& tree_name) {
+void doocore::io::EasyTuple::WriteDataSetToTree(const std::string& file_name, const std::string& tree_name,
+                                                const TreeWriteOptions& options) {
   using namespace doocore::io;
 
   TFile file(file_name.c_str(), "recreate");
+  if (options.compression_algorithm >= 0) file.SetCompressionAlgorithm(options.compression_algorithm);
+  if (options.compression_level >= 0) file.SetCompressionLevel(options.compression_level);
   TTree tree(tree_name.c_str(), tree_name.c_str());
+  if (options.auto_flush != 0) tree.SetAutoFlush(options.auto_flush);
 
-  std::vector<TBranch*> branches;
-  TBranch*              branch_weight(nullptr);
-  double                value_weight;
-  std::map<std::string, double> values_double;
-  std::map<std::string, int> values_cats;
-
-  bool is_weighted(false);
+  double value_weight(0.0);
+  bool   is_weighted(false);
   if (dataset_->isWeighted()) {
     is_weighted = true;
     sinfo << "The dataset is weighted. RooFit allows no access to the weight's name. Thus, it will be called 'weight' in the TTree." << endmsg;
   }
 
+  // resolve all columns once: RooDataSet::get(i) loads entry i into the same 
+  // row objects, so values can be read directly from these in the loop
+  const RooArgSet*                    row = dataset_->get();
+  std::vector<RooAbsArg*>             args;
+  std::vector<const RooAbsReal*>      reals;
+  std::vector<const RooAbsCategory*>  cats;
+
   RooLinkedListIter* it  = dynamic_cast<RooLinkedListIter*>(argset_->createIterator());
   RooAbsArg*         arg = NULL;
   while ((arg=dynamic_cast<RooAbsArg*>(it->Next()))) {
-    RooAbsReal*     real = dynamic_cast<RooAbsReal*>(arg);
-    RooAbsCategory* cat  = dynamic_cast<RooAbsCategory*>(arg);
-    
-    if (real != nullptr) {
-      //real->Print();
-      std::string name_real = real->GetName();
-      std::string name_real_leaflist = name_real + "/D";
-      values_double[name_real] = 0.0;
-      branches.push_back(tree.Branch(name_real.c_str(), &values_double[name_real], name_real_leaflist.c_str()));
+    RooAbsArg* row_arg = row->find(arg->GetName());
+    if (row_arg == NULL) {
+      swarn << "Variable " << arg->GetName() << " not in dataset. Writing zeros to its branch." << endmsg;
     }
-
-    if (cat != nullptr) {
-      //cat->Print();
-      std::string name_cat = cat->GetName();
-      std::string name_cat_leaflist = name_cat + "/I";
-      values_cats[name_cat] = 0;
-      branches.push_back(tree.Branch(name_cat.c_str(), &values_cats[name_cat], name_cat_leaflist.c_str()));
+    if (dynamic_cast<RooAbsReal*>(arg) != nullptr) {
+      args.push_back(arg);
+      reals.push_back(dynamic_cast<const RooAbsReal*>(row_arg));
+    }
+    if (dynamic_cast<RooAbsCategory*>(arg) != nullptr) {
+      args.push_back(arg);
+      cats.push_back(dynamic_cast<const RooAbsCategory*>(row_arg));
     }
   }
   delete it;
+
+  // sized before creating branches, so that branch addresses stay valid
+  std::vector<double> values_double(reals.size(), 0.0);
+  std::vector<int>    values_cats(cats.size(), 0);
+  for (std::size_t i=0, i_real=0, i_cat=0; i<args.size(); ++i) {
+    std::string name = args[i]->GetName();
+    if (dynamic_cast<RooAbsReal*>(args[i]) != nullptr) {
+      tree.Branch(name.c_str(), &values_double[i_real++], (name + "/D").c_str());
+    } else {
+      tree.Branch(name.c_str(), &values_cats[i_cat++], (name + "/I").c_str());
+    }
+  }
   if (is_weighted) {
-    branch_weight = tree.Branch("weight", &value_weight, "weight/D");
+    tree.Branch("weight", &value_weight, "weight/D");
   }
 
+  // copy values of the currently loaded dataset entry
+  auto extract = [&](double* values_real, int* values_cat) {
+    for (std::size_t j=0; j<reals.size(); ++j) {
+      values_real[j] = reals[j] != nullptr ? reals[j]->getVal() : 0.0;
+    }
+    for (std::size_t j=0; j<cats.size(); ++j) {
+      values_cat[j] = cats[j] != nullptr ? cats[j]->getIndex() : 0;
+    }
+  };
+
   Progress p("Writing RooDataSet to TTree", dataset_->numEntries());
-  for (int i=0; i<dataset_->numEntries(); ++i) {
-    const RooArgSet* args = dataset_->get(i);
-    for (auto value : values_double) {
-      values_double[value.first] = args->getRealValue(value.first.c_str());
+  Long64_t num_entries = dataset_->numEntries();
+  if (!options.asynchronous || options.batch_size == 0) {
+    for (Long64_t i=0; i<num_entries; ++i) {
+      dataset_->get(i);
+      extract(values_double.data(), values_cats.data());
+
+      if (is_weighted) {
+        value_weight = dataset_->weight();
+      }
+      tree.Fill();
+      if (i % 1024 == 0) p.set_bytes_processed(file.GetBytesWritten());
+      ++p;
     }
+    p.Finish();
+
+    tree.Write();
+    file.Close();
+    return;
+  }
 
-    for (auto cat : values_cats) {
-      values_cats[cat.first] = args->getCatIndex(cat.first.c_str());
+  doocore::io::tools::EnableRootThreadSafety();
+
+  // two batches: one filled from the dataset, one written in the background
+  const std::size_t batch_size = options.batch_size;
+  WriteBatch        batches[2];
+  for (int k=0; k<2; ++k) {
+    batches[k].reals.resize(batch_size*reals.size());
+    batches[k].cats.resize(batch_size*cats.size());
+    batches[k].weights.resize(batch_size);
+  }
+
+  boost::mutex              mutex;
+  boost::condition_variable condition;
+  Long64_t                  num_produced = 0;
+  Long64_t                  num_consumed = 0;
+  bool                      producer_done = false;
+  bool                      writer_failed = false;
+
+  boost::thread writer([&]() {
+    try {
+      for (Long64_t k=0; ; ++k) {
+        {
+          boost::mutex::scoped_lock lock(mutex);
+          while (num_produced <= k && !producer_done) condition.wait(lock);
+          if (num_produced <= k) break;
+        }
+        const WriteBatch& batch = batches[k%2];
+        for (std::size_t e=0; e<batch.num_entries; ++e) {
+          std::copy(batch.reals.begin()+e*reals.size(), batch.reals.begin()+(e+1)*reals.size(), values_double.begin());
+          std::copy(batch.cats.begin()+e*cats.size(), batch.cats.begin()+(e+1)*cats.size(), values_cats.begin());
+          value_weight = batch.weights[e];
+          tree.Fill();
+        }
+        p.set_bytes_processed(file.GetBytesWritten());
+
+        boost::mutex::scoped_lock lock(mutex);
+        num_consumed = k+1;
+        condition.notify_all();
+      }
+      tree.Write();
+    } catch (...) {
+      boost::mutex::scoped_lock lock(mutex);
+      writer_failed = true;
+      condition.notify_all();
     }
+  });
 
-    if (is_weighted) {
-      value_weight = dataset_->weight();
+  try {
+    for (Long64_t k=0, first_entry=0; first_entry<num_entries; ++k, first_entry+=batch_size) {
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        while (k-num_consumed >= 2 && !writer_failed) condition.wait(lock);
+        if (writer_failed) break;
+      }
+      WriteBatch& batch = batches[k%2];
+      batch.num_entries = std::min<Long64_t>(batch_size, num_entries-first_entry);
+      for (std::size_t e=0; e<batch.num_entries; ++e) {
+        dataset_->get(first_entry+e);
+        extract(batch.reals.data()+e*reals.size(), batch.cats.data()+e*cats.size());
+        if (is_weighted) {
+          batch.weights[e] = dataset_->weight();
+        }
+        ++p;
+      }
+
+      boost::mutex::scoped_lock lock(mutex);
+      num_produced = k+1;
+      condition.notify_all();
     }
-    tree.Fill();
-    ++p;
+  } catch (...) {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      producer_done = true;
+      condition.notify_all();
+    }
+    writer.join();
+    throw;
+  }
+  {
+    boost::mutex::scoped_lock lock(mutex);
+    producer_done = true;
+    condition.notify_all();
   }
+  writer.join();
   p.Finish();
 
-  tree.Write();
+  if (writer_failed) {
+    serr << "doocore::io::EasyTuple::WriteDataSetToTree(...): Writing tree in background thread failed." << endmsg;
+    throw 10;
+  }
   file.Close();
 }
 
+RooDataSet* doocore::io::EasyTuple::ConvertNative(const RooArgSet& argset, const std::string& user_cut_string,
+                                                  const std::string& entry_list_key, IOStatistics& statistics,
+                                                  std::vector<RooFormulaVar*>& formulas) {
+  std::vector<ImportColumn> columns     = ImportColumns(argset, *tree_, cut_variable_range_);
+  Long64_t                  num_entries = tree_->GetEntries();
+
+  // entries known to pass all cuts need no evaluation of the user cut
+  std::vector<Long64_t> entry_list;
+  bool                  use_entry_list = false;
+  if (entry_list_key.length() > 0) {
+    EntryListCache cache(entry_list_directory_);
+    use_entry_list = cache.Load(entry_list_key, num_entries, entry_list);
+    if (use_entry_list) {
+      sinfo << "Reading " << entry_list.size() << " of " << num_entries << " entries from entry list " << cache.FileName(entry_list_key) << endmsg;
+    }
+  }
+  bool subsample = !use_entry_list && SubsampledEntries(entry_list);
+  bool               read_list   = use_entry_list || subsample;
+  // only range cuts are applied while reading, the user cut follows on the imported values
+  Long64_t           num_to_read = read_list ? static_cast<Long64_t>(entry_list.size()) : num_entries;
+  bool               record      = entry_list_key.length() > 0 && !use_entry_list;
+
+  int num_workers = num_threads_;
+  if (num_to_read < num_workers) num_workers = num_to_read > 0 ? num_to_read : 1;
+
+  double                    cache_efficiency = -1.0;
+  std::vector<ImportBuffer> buffers;
+  if (num_workers <= 1 || file_names_.empty()) {
+    if (num_workers > 1) {
+      sinfo << "doocore::io::EasyTuple::ConvertNative(...): Parallel conversion needs a tuple opened from file. Converting on one thread." << endmsg;
+    }
+    std::unique_ptr<ChainPrefetcher> prefetcher;
+    std::function<void(int)>         tree_change_callback;
+    if (chain_ != nullptr) {
+      doocore::io::tools::EnableRootThreadSafety();
+      prefetcher.reset(new ChainPrefetcher(file_names_, tree_name_, active_branches_));
+      prefetcher->Start();
+      tree_change_callback = std::bind(&ChainPrefetcher::NotifyFile, prefetcher.get(), std::placeholders::_1);
+    }
+
+    ImportRange range(0, num_to_read);
+    range.entries        = read_list ? &entry_list : NULL;
+    range.record_entries = record;
+    buffers.resize(1);
+    ImportEntryRange(*tree_, columns, range, buffers[0], tree_change_callback);
+    cache_efficiency = CacheEfficiency(*tree_);
+  } else {
+    doocore::io::tools::EnableRootThreadSafety();
+
+    sinfo << "Converting dataset with " << num_workers << " worker threads." << endmsg;
+
+    // disjoint and ordered entry ranges, one per worker
+    buffers.resize(num_workers);
+    boost::thread_group workers;
+    for (int i=0; i<num_workers; ++i) {
+      ImportRange range(num_to_read*i/num_workers, num_to_read*(i+1)/num_workers);
+      range.entries        = read_list ? &entry_list : NULL;
+      range.record_entries = record;
+      workers.create_thread(boost::bind(&ImportWorker, boost::cref(file_names_), 
+                                        tree_name_, boost::cref(active_branches_),
+                                        boost::cref(columns), range, &buffers[i]));
+    }
+    workers.join_all();
+
+    for (std::vector<ImportBuffer>::const_iterator it = buffers.begin(), end = buffers.end();
+         it != end; ++it) {
+      if (!it->success) {
+        serr << "doocore::io::EasyTuple::ConvertNative(...): Worker thread failed converting its entry range." << endmsg;
+        throw 7;
+      }
+    }
+
+    // mean efficiency over workers with a read cache
+    int num_caches = 0;
+    for (std::vector<ImportBuffer>::const_iterator it = buffers.begin(), end = buffers.end();
+         it != end; ++it) {
+      if (it->cache_efficiency < 0.0) continue;
+      cache_efficiency = (cache_efficiency*num_caches + it->cache_efficiency)/(num_caches+1);
+      ++num_caches;
+    }
+  }
+  if (!use_entry_list && user_cut_string.length() > 0) {
+    ApplyUserCut(argset, columns, user_cut_string, buffers);
+  }
+
+  IOStatistics buffer_statistics;
+  for (std::vector<ImportBuffer>::const_iterator it = buffers.begin(), end = buffers.end();
+       it != end; ++it) {
+    buffer_statistics += it->statistics;
+  }
+  ReportReadStatistics(buffer_statistics.read_calls, buffer_statistics.bytes_read, cache_efficiency);
+  AddDecompressedBytes(*tree_, active_branches_, buffer_statistics.bytes_read, buffer_statistics);
+  statistics += buffer_statistics;
+
+  if (record) {
+    std::vector<Long64_t> accepted;
+    for (std::vector<ImportBuffer>::const_iterator it = buffers.begin(), end = buffers.end();
+         it != end; ++it) {
+      accepted.insert(accepted.end(), it->entries.begin(), it->entries.end());
+    }
+    EntryListCache(entry_list_directory_).Save(entry_list_key, num_entries, accepted);
+  }
+
+  // formula variables as compiled kernels on the imported columns
+  std::chrono::steady_clock::time_point time_add_column_start = std::chrono::steady_clock::now();
+  RooArgSet                  dataset_set(argset);
+  RooArgSet                  formula_vars;
+  std::vector<FormulaColumn> formula_columns = CompileFormulaColumns(formulas, columns);
+  for (std::vector<FormulaColumn>::const_iterator it = formula_columns.begin(), end = formula_columns.end();
+       it != end; ++it) {
+    sinfo << "Adding formula " << it->formula->GetName() << " to dataset (compiled)." << endmsg;
+    RooRealVar* var = new RooRealVar(it->formula->GetName(), it->formula->GetTitle(), 0.0, it->formula->getUnit());
+    var->removeRange();
+    formula_vars.addOwned(*var);
+  }
+  dataset_set.add(formula_vars);
+  EvaluateFormulaColumns(formula_columns, buffers, num_threads_);
+  statistics.time_add_column += SecondsSince(time_add_column_start);
+
+  std::chrono::steady_clock::time_point time_insert_start = std::chrono::steady_clock::now();
+  RooDataSet* dataset = FillDataSet(dataset_set, columns, buffers);
+  statistics.time_dataset_insert += SecondsSince(time_insert_start);
+  return dataset;
+}
+
+void doocore::io::EasyTuple::ForEachChunk(std::size_t chunk_size,
+                                          const std::function<void(const TupleChunk&)>& callback,
+                                          const std::string& cut) {
+  CheckTree();
+  if (chunk_size == 0) {
+    serr << "doocore::io::EasyTuple::ForEachChunk(...): Chunk size has to be positive." << endmsg;
+    throw 9;
+  }
+  doocore::io::tools::EnableRootThreadSafety();
+
+  std::vector<ImportColumn> columns     = ImportColumns(*argset_, *tree_, cut_variable_range_);
+  Long64_t                  num_entries = tree_->GetEntries();
+  std::vector<Long64_t>     entry_list;
+  bool                      subsample   = SubsampledEntries(entry_list);
+  Long64_t                  num_to_read = subsample ? static_cast<Long64_t>(entry_list.size()) : num_entries;
+
+  // compiled here so that invalid cuts throw in the calling thread
+  std::unique_ptr<UserCut>  user_cut;
+  if (cut.length() > 0) user_cut.reset(new UserCut(*argset_, columns, cut));
+
+  // two chunks: one handed to the callback, one filled in the background
+  TupleChunk chunks[2];
+  for (int k=0; k<2; ++k) {
+    for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+         it != end; ++it) {
+      chunks[k].names.push_back(it->name);
+    }
+    chunks[k].columns.assign(columns.size(), std::vector<double>());
+    for (std::size_t i=0; i<columns.size(); ++i) {
+      chunks[k].columns[i].reserve(chunk_size);
+    }
+  }
+
+  // read cache for the whole scan, filled while the previous chunk is processed
+  if (tree_->GetCacheSize() <= 0) ConfigureReadCache(*tree_, chunks[0].names);
+  for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    tree_->AddBranchToCache(it->name.c_str(), true);
+  }
+  tree_->SetCacheEntryRange(0, num_entries);
+  std::chrono::steady_clock::time_point time_start       = std::chrono::steady_clock::now();
+  IOStatistics                          statistics;
+
+  boost::mutex              mutex;
+  boost::condition_variable condition;
+  Long64_t                  num_produced = 0;
+  Long64_t                  num_consumed = 0;
+  bool                      producer_done = false;
+  bool                      producer_failed = false;
+  bool                      consumer_aborted = false;
+
+  // prefetch next file of a chain while reading the current one
+  std::unique_ptr<ChainPrefetcher> prefetcher;
+  std::function<void(int)>         tree_change_callback;
+  if (chain_ != nullptr) {
+    prefetcher.reset(new ChainPrefetcher(file_names_, tree_name_, active_branches_));
+    prefetcher->Start();
+    tree_change_callback = std::bind(&ChainPrefetcher::NotifyFile, prefetcher.get(), std::placeholders::_1);
+  }
+
+  boost::thread producer([&]() {
+    try {
+      BlockImporter importer(*tree_, columns, user_cut.get(), tree_change_callback);
+      for (Long64_t k=0, first=0; first<num_to_read; ++k, first+=chunk_size) {
+        {
+          boost::mutex::scoped_lock lock(mutex);
+          while (k-num_consumed >= 2 && !consumer_aborted) condition.wait(lock);
+          if (consumer_aborted) break;
+        }
+        TupleChunk& chunk = chunks[k%2];
+        Long64_t    last  = std::min<Long64_t>(first+chunk_size, num_to_read);
+        chunk.first_entry = subsample ? entry_list[first] : first;
+        chunk.last_entry  = subsample ? entry_list[last-1]+1 : last;
+        importer.Import(first, last, chunk.columns, chunk.num_entries, subsample ? &entry_list : NULL);
+
+        boost::mutex::scoped_lock lock(mutex);
+        num_produced = k+1;
+        condition.notify_all();
+      }
+      statistics = importer.statistics();
+    } catch (...) {
+      boost::mutex::scoped_lock lock(mutex);
+      producer_failed = true;
+    }
+    boost::mutex::scoped_lock lock(mutex);
+    producer_done = true;
+    condition.notify_all();
+  });
+
+  try {
+    for (Long64_t k=0; ; ++k) {
+      {
+        boost::mutex::scoped_lock lock(mutex);
+        while (num_produced <= k && !producer_done) condition.wait(lock);
+        if (num_produced <= k) break;
+      }
+      callback(chunks[k%2]);
+
+      boost::mutex::scoped_lock lock(mutex);
+      num_consumed = k+1;
+      condition.notify_all();
+    }
+  } catch (...) {
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      consumer_aborted = true;
+      condition.notify_all();
+    }
+    producer.join();
+    throw;
+  }
+  producer.join();
+
+  if (producer_failed) {
+    serr << "doocore::io::EasyTuple::ForEachChunk(...): Reading chunks from tree failed." << endmsg;
+    throw 9;
+  }
+  ReportReadStatistics(statistics.read_calls, statistics.bytes_read, CacheEfficiency(*tree_));
+  AddDecompressedBytes(*tree_, active_branches_, statistics.bytes_read, statistics);
+  statistics.time_total = SecondsSince(time_start);
+  io_statistics_ += statistics;
+  PublishIOStatistics("EasyTuple::ForEachChunk", statistics);
+}
+
+const doocore::io::CompactColumnStore& doocore::io::EasyTuple::ConvertToCompactStore(const std::string& cut) {
+  CheckTree();
+
+  std::vector<ImportColumn> columns = ImportColumns(*argset_, *tree_, cut_variable_range_);
+  std::vector<std::string>  names;
+  std::vector<ColumnType>   types;
+  std::vector<bool>         is_category;
+  for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    names.push_back(it->name);
+    types.push_back(TreeColumnReader::BranchColumnType(*tree_, it->name));
+    is_category.push_back(it->is_category);
+  }
+
+  std::shared_ptr<CompactColumnStore> store = std::make_shared<CompactColumnStore>(names, types, is_category);
+  ForEachChunk(kCompactChunkSize, [&](const TupleChunk& chunk) {
+    store->AddEntries(chunk.columns, chunk.num_entries);
+  }, cut);
+  compact_store_ = store;
+
+  sinfo << "Converted " << store->num_entries() << " entries into compact store using " 
+        << store->MemorySize()/(1024.0*1024.0) << " MB." << endmsg;
+  return *compact_store_;
+}
+
+RooDataHist& doocore::io::EasyTuple::ConvertToDataHist(const std::string& cut) {
+  CheckTree();
+
+  std::vector<ImportColumn>  columns     = ImportColumns(*argset_, *tree_, cut_variable_range_);
+  std::vector<HistogramAxis> axes        = HistogramAxes(*argset_, columns);
+  std::vector<double>        counts(NumHistogramBins(axes), 0.0);
+  Long64_t                   num_entries = tree_->GetEntries();
+
+  int num_workers = num_threads_;
+  if (num_entries < num_workers) num_workers = num_entries > 0 ? num_entries : 1;
+
+  if (num_workers <= 1 || file_names_.empty()) {
+    if (num_workers > 1) {
+      sinfo << "doocore::io::EasyTuple::ConvertToDataHist(...): Parallel filling needs a tuple opened from file. Filling on one thread." << endmsg;
+    }
+    ForEachChunk(kHistogramChunkSize, [&](const TupleChunk& chunk) {
+      FillBinCounts(axes, chunk.columns, chunk.num_entries, counts);
+    }, cut);
+  } else {
+    doocore::io::tools::EnableRootThreadSafety();
+    sinfo << "Filling histogram with " << num_workers << " worker threads." << endmsg;
+
+    std::chrono::steady_clock::time_point time_start  = std::chrono::steady_clock::now();
+    std::vector<Long64_t>                 entry_list;
+    bool                                  subsample   = SubsampledEntries(entry_list);
+    Long64_t                              num_to_read = subsample ? static_cast<Long64_t>(entry_list.size()) : num_entries;
+
+    // one set of bin counts per worker, added up afterwards
+    std::vector<std::vector<double> > worker_counts(num_workers, std::vector<double>(counts.size(), 0.0));
+    std::vector<IOStatistics>         worker_statistics(num_workers);
+    std::unique_ptr<bool[]>           success(new bool[num_workers]());
+    // one user cut per worker, compiled here so that invalid cuts throw in this thread
+    std::vector<std::unique_ptr<UserCut> > user_cuts(num_workers);
+    if (cut.length() > 0) {
+      for (int i=0; i<num_workers; ++i) user_cuts[i].reset(new UserCut(*argset_, columns, cut));
+    }
+    boost::thread_group               workers;
+    for (int i=0; i<num_workers; ++i) {
+      ImportRange range(num_to_read*i/num_workers, num_to_read*(i+1)/num_workers);
+      range.entries = subsample ? &entry_list : NULL;
+      workers.create_thread([&, i, range]() {
+        HistogramWorker(file_names_, tree_name_, active_branches_, columns, axes, user_cuts[i].get(), range,
+                        &worker_counts[i], &worker_statistics[i], &success[i]);
+      });
+    }
+    workers.join_all();
+
+    IOStatistics statistics;
+    for (int i=0; i<num_workers; ++i) {
+      if (!success[i]) {
+        serr << "doocore::io::EasyTuple::ConvertToDataHist(...): Worker thread failed filling its entry range." << endmsg;
+        throw 7;
+      }
+      for (std::size_t bin=0; bin<counts.size(); ++bin) {
+        counts[bin] += worker_counts[i][bin];
+      }
+      statistics += worker_statistics[i];
+    }
+    ReportReadStatistics(statistics.read_calls, statistics.bytes_read, -1.0);
+    AddDecompressedBytes(*tree_, active_branches_, statistics.bytes_read, statistics);
+    statistics.time_total = SecondsSince(time_start);
+    io_statistics_ += statistics;
+    PublishIOStatistics("EasyTuple::ConvertToDataHist", statistics);
+  }
+
+  RooArgSet variables;
+  for (std::vector<ImportColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    variables.add(*argset_->find(it->name.c_str()));
+  }
+  std::shared_ptr<RooDataHist> datahist = std::make_shared<RooDataHist>("datahist", "datahist", variables);
+  const RooArgSet*             row      = datahist->get();
+  std::vector<RooRealVar*>     row_reals(columns.size(), NULL);
+  std::vector<RooCategory*>    row_cats(columns.size(), NULL);
+  for (std::size_t i=0; i<columns.size(); ++i) {
+    if (columns[i].is_category) {
+      row_cats[i]  = dynamic_cast<RooCategory*>(row->find(columns[i].name.c_str()));
+    } else {
+      row_reals[i] = dynamic_cast<RooRealVar*>(row->find(columns[i].name.c_str()));
+    }
+  }
+
+  // add bin counts with coordinates at the bin centres
+  double sum_entries = 0.0;
+  for (std::size_t bin=0; bin<counts.size(); ++bin) {
+    if (counts[bin] == 0.0) continue;
+    for (std::size_t i=0; i<axes.size(); ++i) {
+      const HistogramAxis& axis     = axes[i];
+      int                  axis_bin = (bin/axis.stride) % std::max(1, axis.num_bins);
+      if (row_cats[i] != NULL) {
+        row_cats[i]->setIndex(axis.category_indices[axis_bin]);
+      } else {
+        row_reals[i]->setVal(0.5*(axis.boundaries[axis_bin]+axis.boundaries[axis_bin+1]));
+      }
+    }
+    datahist->add(*row, counts[bin]);
+    sum_entries += counts[bin];
+  }
+  datahist_ = datahist;
+
+  sinfo << "Filled " << sum_entries << " entries into RooDataHist with " << counts.size() << " bins." << endmsg;
+  return *datahist_;
+}
+
+void doocore::io::EasyTuple::CheckTree() const {
+  if (tree_ == NULL) {
+    serr << "No tree available in EasyTuple. Cannot read columns." << endmsg;
+    throw 8;
+  }
+}
+
+void doocore::io::EasyTuple::OpenFile() {
+  const std::string& file_name = file_names_.front();
+  file_.reset(new TFile(file_name.c_str()));
+  if (file_->IsZombie() || file_->GetNkeys() <= 0) {
+    serr << "File " << file_name << " could not be opened properly." << endmsg;
+    throw 1;
+  }
+
+  tree_ = dynamic_cast<TTree*>(file_->Get(tree_name_.c_str()));
+  if (tree_ == NULL) {
+    serr << "Tree " << tree_name_ << " could not be opened properly." << endmsg;
+    throw 2;
+  }
+}
+
+void doocore::io::EasyTuple::OpenChain() {
+  chain_.reset(new TChain(tree_name_.c_str()));
+  for (std::vector<std::string>::const_iterator it = file_names_.begin(), end = file_names_.end();
+       it != end; ++it) {
+    // open each file now to detect missing files or trees early
+    if (chain_->Add(it->c_str(), 0) <= 0) {
+      serr << "File " << *it << " or tree " << tree_name_ << " in it could not be opened properly." << endmsg;
+      throw 1;
+    }
+  }
+  tree_ = chain_.get();
+}
+
+void doocore::io::EasyTuple::CloseTree() {
+  // a tree read from a single file is deleted before its file
+  if (tree_ != NULL && file_ != nullptr) delete tree_;
+  tree_ = NULL;
+  file_.reset();
+  chain_.reset();
+}
+
+void doocore::io::EasyTuple::DetachDataSet() {
+  if (dataset_ != nullptr && dataset_.use_count() > 1) {
+    dataset_ = std::make_shared<RooDataSet>(*dataset_);
+  }
+}
+
+void doocore::io::EasyTuple::ActivateBranches() {
+  active_branches_.clear();
+  if (argset_->getSize() > 0) tree_->SetBranchStatus("*", 0);
+  
+  RooLinkedListIter* it  = (RooLinkedListIter*)argset_->createIterator();
+  RooAbsArg*         arg = NULL;
+  
+  while ((arg=(RooAbsArg*)it->Next())) {
+    RooRealVar* var = dynamic_cast<RooRealVar*>(arg);
+    RooCategory* cat = dynamic_cast<RooCategory*>(arg);
+    
+    if (var != NULL || cat != NULL) {
+      if (tree_->GetBranch(arg->GetName()) == NULL) {
+        swarn << "Branch " << arg->GetName() << " not in tree. Ignoring." << endmsg;
+      } else {
+        tree_->SetBranchStatus(arg->GetName(), 1);
+        active_branches_.push_back(arg->GetName());
+      }
+    }
+  }
+  delete it;
+
+  ConfigureReadCache(*tree_, active_branches_);
+}
+
+bool doocore::io::EasyTuple::SubsampledEntries(std::vector<Long64_t>& entries) const {
+  if (subsample_fraction_ >= 1.0) return false;
+  entries = SubsampleEntries(*tree_, subsample_fraction_, subsample_seed_);
+  sinfo << "Reading random subsample of " << entries.size() << " of " << tree_->GetEntries() << " entries (fraction " << subsample_fraction_ << ", seed " << subsample_seed_ << ")." << endmsg;
+  return true;
+}
+
+std::string doocore::io::EasyTuple::SourceKey() const {
+  namespace fs = boost::filesystem;
+
+  std::vector<std::string> file_names(file_names_);
+  if (file_names.empty() && tree_ != NULL && tree_->GetCurrentFile() != NULL) {
+    file_names.push_back(tree_->GetCurrentFile()->GetName());
+  }
+  if (file_names.empty()) return "";
+
+  std::stringstream key;
+  for (std::vector<std::string>::const_iterator it = file_names.begin(), end = file_names.end();
+       it != end; ++it) {
+    if (!fs::exists(*it)) return "";
+    key << "file=" << fs::canonical(*it).string() << "@" << fs::last_write_time(*it) << ";";
+  }
+  key << "tree=" << (tree_name_.length() > 0 ? tree_name_ : std::string(tree_->GetName()));
+  return key.str();
+}
+
+std::string doocore::io::EasyTuple::SnapshotKey(const RooArgSet& argset, const std::string& cut_string) const {
+  std::string source_key = SourceKey();
+  if (source_key.length() == 0) {
+    swarn << "doocore::io::EasyTuple::SnapshotKey(...): Tree is not read from a local file. Snapshot cache will not be used." << endmsg;
+    return "";
+  }
+
+  std::stringstream key;
+  key.precision(std::numeric_limits<double>::digits10+2);
+  key << source_key;
+  key << ";vars=";
+
+  RooLinkedListIter* it  = (RooLinkedListIter*)argset.createIterator();
+  RooAbsArg*         arg = NULL;
+  while ((arg=(RooAbsArg*)it->Next())) {
+    RooRealVar*    var     = dynamic_cast<RooRealVar*>(arg);
+    RooCategory*   cat     = dynamic_cast<RooCategory*>(arg);
+    RooFormulaVar* formula = dynamic_cast<RooFormulaVar*>(arg);
+    key << arg->ClassName() << ":" << arg->GetName();
+    if (var != NULL) key << "[" << var->getMin() << "," << var->getMax() << "]";
+    if (cat != NULL) AppendCategoryStates(*cat, key);
+    if (formula != NULL) formula->printMetaArgs(key);
+    key << ",";
+  }
+  delete it;
+
+  key << ";cut=" << cut_string;
+  key << ";max_events=" << num_maximum_events_;
+  key << ";subsample=" << subsample_fraction_ << "," << subsample_seed_;
+
+  return key.str();
+}
+
+std::string doocore::io::EasyTuple::EntryListKey(const RooArgSet& argset, const std::string& cut_string) const {
+  std::string source_key = SourceKey();
+  if (source_key.length() == 0) {
+    swarn << "doocore::io::EasyTuple::EntryListKey(...): Tree is not read from a local file. Entry list will not be used." << endmsg;
+    return "";
+  }
+
+  // variable ranges are applied on import even if not part of the cut string
+  // (e.g. with kNoCuts), so all ranges and category states are part of the key
+  std::stringstream key;
+  key.precision(std::numeric_limits<double>::digits10+2);
+  key << "entrylist;" << source_key;
+  key << ";cut=" << cut_string;
+  key << ";range_cut=" << cut_variable_range_;
+  key << ";vars=";
+  RooLinkedListIter* it  = (RooLinkedListIter*)argset.createIterator();
+  RooAbsArg*         arg = NULL;
+  while ((arg=(RooAbsArg*)it->Next())) {
+    RooRealVar*  var = dynamic_cast<RooRealVar*>(arg);
+    RooCategory* cat = dynamic_cast<RooCategory*>(arg);
+    if (var != NULL) key << var->GetName() << "[" << var->getMin() << "," << var->getMax() << "],";
+    if (cat != NULL) AppendCategoryStates(*cat, key);
+  }
+  delete it;
+  key << ";max_events=" << num_maximum_events_;
+  key << ";subsample=" << subsample_fraction_ << "," << subsample_seed_;
+
+  return key.str();
+}
+
 RooRealVar& doocore::io::EasyTuple::Var(const std::string& name) {
-  if (dataset_ != NULL && dataset_->get()->find(name.c_str()) != NULL) {
+  DetachDataSet();
+  return const_cast<RooRealVar&>(static_cast<const doocore::io::EasyTuple*>(this)->Var(name));
+}
+
+const RooRealVar& doocore::io::EasyTuple::Var(const std::string& name) const {
+  if (dataset_ != nullptr && dataset_->get()->find(name.c_str()) != NULL) {
     RooRealVar* var = dynamic_cast<RooRealVar*>(dataset_->get()->find(name.c_str()));
     if (var != NULL) {
       return *var;
@@ -373,7 +2178,3 @@ RooRealVar& doocore::io::EasyTuple::Var(const std::string& name) {
     throw 5;
   }
 }
-
-const RooRealVar& doocore::io::EasyTuple::Var(const std::string& name) const {
-  return const_cast<doocore::io::EasyTuple*>(this)->Var(name);
-}
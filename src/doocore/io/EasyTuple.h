@@ -4,6 +4,8 @@
 // from STL
 #include <string>
 #include <vector>
+#include <functional>
+#include <memory>
 
 // from ROOT
 #include "TTree.h"
@@ -12,11 +14,20 @@
 #include "RooCmdArg.h"
 #include "RooArgSet.h"
 
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/TreeColumnReader.h"
+#include "doocore/io/CompactColumnStore.h"
+#include "doocore/io/IOStatistics.h"
+
 // forward decalarations
 class RooArgSet;
 class TFile;
+class TChain;
 class RooDataSet;
+class RooDataHist;
 class RooRealVar;
+class RooFormulaVar;
 
 namespace doocore {
 namespace io {
@@ -27,6 +38,64 @@ enum VariableRangeCutting {
   kCutExclusive
 };
   
+/*! @struct doocore::io::TupleChunk
+ * @brief Column buffers of one chunk of a tree as handed out by EasyTuple::ForEachChunk()
+ *
+ * Columns are stored as structure of arrays, i.e. one vector per variable 
+ * with num_entries valid values each. The buffers are reused for subsequent
+ * chunks, so references must not be kept beyond the callback.
+ */
+struct TupleChunk {
+  TupleChunk() : num_entries(0), first_entry(0), last_entry(0) {}
+
+  /**
+   *  @brief Get index of a column by name
+   *
+   *  @param name name of the column
+   *  @return index of the column or -1 if not found
+   */
+  int Index(const std::string& name) const {
+    for (std::size_t i=0; i<names.size(); ++i) {
+      if (names[i] == name) return i;
+    }
+    return -1;
+  }
+
+  /// names of the columns
+  std::vector<std::string> names;
+  /// column buffers, each containing num_entries values
+  std::vector<std::vector<double> > columns;
+  /// number of entries passing all cuts in this chunk
+  std::size_t num_entries;
+  /// first tree entry covered by this chunk
+  Long64_t first_entry;
+  /// tree entry after the last entry covered by this chunk
+  Long64_t last_entry;
+};
+
+/*! @struct doocore::io::TreeWriteOptions
+ * @brief Options for EasyTuple::WriteDataSetToTree()
+ *
+ * Negative compression settings and an auto flush value of 0 keep the ROOT 
+ * defaults.
+ */
+struct TreeWriteOptions {
+  TreeWriteOptions() 
+  : compression_algorithm(-1), compression_level(-1), auto_flush(0), 
+    asynchronous(false), batch_size(10000) {}
+
+  /// compression algorithm of the output file (see ROOT::ECompressionAlgorithm)
+  int compression_algorithm;
+  /// compression level of the output file (0-9)
+  int compression_level;
+  /// auto flush setting of the tree (see TTree::SetAutoFlush())
+  Long64_t auto_flush;
+  /// fill and compress the tree in a background thread
+  bool asynchronous;
+  /// number of entries handed to the background thread at once
+  std::size_t batch_size;
+};
+
 /*! @class doocore::io::EasyTuple
  * @brief Easy tuple loading into TTree/RooDataSet without boilerplate code
  *
@@ -69,6 +138,9 @@ enum VariableRangeCutting {
  *   EasyTuple etuple2("tuplefile.root", "Bs2Jpsif0",
  *                     RooArgSet(varMass,varProptime,varOmega,cutVar));
  *   TTree& tree = etuple2.tree();
+ *
+ *   // quick statistics without RooFit: read branches in native type
+ *   std::vector<float> masses = etuple2.Column<float>("varMass");
  * }
  * @endcode
  *
@@ -91,6 +163,19 @@ enum VariableRangeCutting {
  * conversion to a RooDataSet took a few seconds compared to several minutes 
  * when not deactivating the branches (and compared to a few split seconds when
  * directly using a reduced fit tuple without unnecessary branches).
+ *
+ * Additionally, a TTreeCache is set up for exactly the active branches. Its
+ * size is derived from the branches' basket sizes, a short learning phase 
+ * adds branches read by cut formulas. The number of read calls, the amount 
+ * of data read and the cache hit rate are reported after each conversion.
+ *
+ * If no RooCmdArgs besides Cut() are passed to ConvertToDataSet(), EasyTuple
+ * reads the branches itself instead of using RooFit's tree import. Variable
+ * range cuts (see set_cut_variable_range()) are then applied as compiled
+ * comparisons on blocks of entries. The user-supplied cut is evaluated as 
+ * RooFormula on the imported variables exactly as in RooFit's import (i.e. 
+ * category labels like @c cat==cat::state can be used and only variables of
+ * the RooArgSet are known), but only for entries passing the range cuts.
  */
 class EasyTuple {
  public:
@@ -105,6 +190,25 @@ class EasyTuple {
    *  @param argset RooArgSet of parameters to activate
    */
   EasyTuple(const std::string& file_name, const std::string& tree_name, const RooArgSet& argset=RooArgSet());
+
+  /**
+   *  @brief Constructor for EasyTuple reading a chain of files
+   *
+   *  All files are chained into one TChain in the given order. File names may 
+   *  contain shell wildcards (@c *, @c ? and @c [...]) which are expanded and 
+   *  sorted. Names without wildcards (e.g. remote URLs) are used as given. 
+   *  Branches not in the supplied RooArgSet are deactivated as for a single 
+   *  file.
+   *
+   *  While reading the chain sequentially, the next local file is prefetched in a 
+   *  background thread (see ChainPrefetcher). With set_num_threads(), the 
+   *  conversion is split into entry ranges across the whole chain.
+   *
+   *  @param file_names file names or wildcard patterns of TFiles to chain
+   *  @param tree_name tree name in each TFile
+   *  @param argset RooArgSet of parameters to activate
+   */
+  EasyTuple(const std::vector<std::string>& file_names, const std::string& tree_name, const RooArgSet& argset=RooArgSet());
   
   /**
    *  @brief Constructor for EasyTuple based on a given TTree
@@ -131,15 +235,76 @@ class EasyTuple {
   /**
    *  @brief Copy constructor for EasyTuple
    *
+   *  The copy opens its own TFile/TTree (if any) but shares an already 
+   *  converted RooDataSet with @a other. Reading the shared dataset via 
+   *  shared_dataset() or the const accessors never copies it. It is copied 
+   *  only when one of the tuples requests write access via the non-const 
+   *  dataset() or Var(), i.e. copy-on-write.
+   *
    *  @param other other EasyTuple to copy
    */
   EasyTuple(const EasyTuple& other);
+
+  /**
+   *  @brief Move constructor for EasyTuple
+   *
+   *  Takes over all files, trees and datasets of @a other without reopening
+   *  or copying. @a other is left without tree and dataset.
+   *
+   *  @param other other EasyTuple to move from
+   */
+  EasyTuple(EasyTuple&& other);
+
+  /**
+   *  @brief Copy assignment for EasyTuple (see copy constructor)
+   *
+   *  @param other other EasyTuple to copy
+   *  @return this EasyTuple
+   */
+  EasyTuple& operator=(const EasyTuple& other);
+
+  /**
+   *  @brief Move assignment for EasyTuple (see move constructor)
+   *
+   *  @param other other EasyTuple to move from
+   *  @return this EasyTuple
+   */
+  EasyTuple& operator=(EasyTuple&& other);
   
   /**
    *  @brief Destructor for EasyTuple
    */
   ~EasyTuple();
-  
+
+  /**
+   *  @brief Create EasyTuple from a numeric text file
+   *
+   *  Reads whitespace- or comma-separated columns (one entry per line) into a
+   *  RooDataSet, parsing the memory-mapped file with @a num_threads threads
+   *  (see TextFileParser). Columns are named by @a column_names, by a header
+   *  line in the file or, if neither is given, by the order of @a argset.
+   *  Only columns in @a argset (RooRealVars and RooCategorys via their index)
+   *  are kept. Entries outside variable ranges or with undefined category
+   *  states are rejected as in ConvertToDataSet().
+   *
+   *  @code
+   *  RooRealVar varMass("varMass", "mass", 5200, 5600);
+   *  RooRealVar varTime("varTime", "time", 0.3, 15);
+   *  EasyTuple etuple(EasyTuple::FromTextFile("toys.txt", RooArgSet(varMass,varTime),
+   *                                           std::vector<std::string>(), 4));
+   *  const RooDataSet& data = etuple.shared_dataset();
+   *  @endcode
+   *
+   *  @param file_name name of the text file
+   *  @param argset RooArgSet of variables to import
+   *  @param column_names names of the columns in the file (optional)
+   *  @param num_threads number of threads to parse with
+   *  @return EasyTuple owning the imported RooDataSet
+   */
+  static EasyTuple FromTextFile(const std::string& file_name, const RooArgSet& argset,
+                                const std::vector<std::string>& column_names=std::vector<std::string>(),
+                                int num_threads=1);
+
   /**
    *  @brief Get opened TTree
    *
@@ -153,6 +318,20 @@ class EasyTuple {
    *  @return the TTree reference
    */
   TTree& tree() {return *tree_;}
+
+  /**
+   *  @brief Get names of the files the tree is read from
+   *
+   *  @return the file names (empty if constructed from an existing tree)
+   */
+  const std::vector<std::string>& file_names() const {return file_names_;}
+
+  /**
+   *  @brief Get name of the tree in the files
+   *
+   *  @return the tree name
+   */
+  const std::string& tree_name() const {return tree_name_;}
   
   /**
    *  @brief Get previously converted RooDataSet
@@ -160,13 +339,29 @@ class EasyTuple {
    *  @return the RooDataSet reference
    */
   const RooDataSet& dataset() const {return *dataset_;}
+
+  /**
+   *  @brief Get previously converted RooDataSet for reading
+   *
+   *  Same as the const dataset(), but also usable on non-const tuples. A 
+   *  dataset shared with copies of this EasyTuple is not copied.
+   *
+   *  @return the RooDataSet reference
+   */
+  const RooDataSet& shared_dataset() const {return *dataset_;}
   
   /**
-   *  @brief Get previously converted RooDataSet
+   *  @brief Get previously converted RooDataSet for writing
+   *
+   *  If the dataset is shared with copies of this EasyTuple, this tuple gets
+   *  its own copy first so that modifications do not affect the copies. 
+   *  References obtained from this tuple before (e.g. from 
+   *  ConvertToDataSet()) then still refer to the dataset of the copies. Use 
+   *  shared_dataset() for read-only access.
    *
    *  @return the RooDataSet reference
    */
-  RooDataSet& dataset() {return *dataset_;}
+  RooDataSet& dataset();
   
   /**
    *  @brief Get RooDataSet based on opened TTree and supplied optional RooCmdArgs
@@ -239,10 +434,17 @@ class EasyTuple {
    *
    *  This function can be used to write a stored RooDataSet back into a TTree.
    *
+   *  In asynchronous mode (see TreeWriteOptions), values are extracted from 
+   *  the dataset into two alternating batches while a background thread fills
+   *  the previous batch into the tree, compresses the baskets and writes the 
+   *  tree. Extraction and compression therefore overlap.
+   *
    *  @param file_name file name of TFile to use
    *  @param tree_name tree name in TFile to use
+   *  @param options compression and threading options
    */
-  void WriteDataSetToTree(const std::string& file_name, const std::string& tree_name);
+  void WriteDataSetToTree(const std::string& file_name, const std::string& tree_name,
+                          const TreeWriteOptions& options=TreeWriteOptions());
 
   /**
    *  @brief Access variable in dataset
@@ -261,12 +463,177 @@ class EasyTuple {
    *
    *  After the tuple has been converted to a RooDataSet, use this function to
    *  access any RooRealVar in the RooDataSet. If not found or tuple not
-   *  converted to a dataset, an exception is thrown.
+   *  converted to a dataset, an exception is thrown. As for the non-const 
+   *  dataset(), a dataset shared with copies of this EasyTuple is copied 
+   *  first. Use the const Var() for read-only access.
    *
    *  @param name name of the variable
    *  @return reference to the appropriate RooRealVar in the dataset
    */
   RooRealVar& Var(const std::string& name);
+
+  /**
+   *  @brief Read a branch into a contiguous vector without RooFit
+   *
+   *  The branch is read in its native type and converted to @a T. If @a T 
+   *  matches the branch type (e.g. float for Float_t branches), values are 
+   *  copied unchanged. The maximum number of events set via 
+   *  set_num_maximum_events() and the subsample set via 
+   *  set_subsample_fraction() are respected, cuts are not applied. If an 
+   *  entry cannot be read, an exception is thrown, so the vector always has
+   *  one value per (subsampled) entry.
+   *
+   *  @code
+   *  std::vector<float> mass = etuple.Column<float>("varMass");
+   *  @endcode
+   *
+   *  @param name name of the branch
+   *  @return vector with one value per tree entry
+   */
+  template<typename T>
+  std::vector<T> Column(const std::string& name) {
+    std::vector<std::vector<T> > columns = Columns<T>(std::vector<std::string>(1, name));
+    return std::move(columns.front());
+  }
+
+  /**
+   *  @brief Read several branches into contiguous vectors without RooFit
+   *
+   *  Multi-column variant of Column(). All branches are read in one pass 
+   *  over the tree. As for Column(), an exception is thrown if an entry 
+   *  cannot be read.
+   *
+   *  @param names names of the branches
+   *  @return one vector per branch in order of @a names
+   */
+  template<typename T>
+  std::vector<std::vector<T> > Columns(const std::vector<std::string>& names) {
+    CheckTree();
+    std::vector<Long64_t>        entries;
+    bool                         subsample   = SubsampledEntries(entries);
+    Long64_t                     num_entries = subsample ? static_cast<Long64_t>(entries.size()) : tree_->GetEntries();
+    TreeColumnReader             reader(*tree_, names);
+    std::vector<std::vector<T> > columns(names.size());
+    for (std::size_t i=0; i<names.size(); ++i) {
+      columns[i].reserve(num_entries);
+    }
+    for (Long64_t position=0; position<num_entries; ++position) {
+      Long64_t entry = subsample ? entries[position] : position;
+      if (!reader.LoadEntry(entry)) {
+        serr << "Entry " << entry << " of tree " << tree_->GetName() << " cannot be read. Cannot read columns." << endmsg;
+        throw 6;
+      }
+      for (std::size_t i=0; i<names.size(); ++i) {
+        columns[i].push_back(reader.ValueAs<T>(i));
+      }
+    }
+    return columns;
+  }
+
+  /**
+   *  @brief Stream over the tree in chunks of bounded size
+   *
+   *  The tree is read in chunks of @a chunk_size consecutive entries. For 
+   *  each chunk the callback is called with column buffers of all variables
+   *  in the internal argset available in the tree, with range cuts and the 
+   *  optional @a cut already applied. The cut is evaluated as RooFormula on 
+   *  the imported values as in ConvertToDataSet(), i.e. category labels like
+   *  @c catTag==catTag::tagged can be used and only variables of the argset
+   *  are known. Memory usage is bounded by two chunks 
+   *  independent of the tree size: while the callback processes one chunk, 
+   *  the next chunk is read in a background thread (with a TTreeCache for 
+   *  the scanned branches). With set_subsample_fraction(), chunks consist of
+   *  @a chunk_size entries of the subsample.
+   *
+   *  The callback must not access the tree of this EasyTuple.
+   *
+   *  @code
+   *  double sum = 0.0;
+   *  etuple.ForEachChunk(100000, [&](const TupleChunk& chunk) {
+   *    const std::vector<double>& mass = chunk.columns[chunk.Index("varMass")];
+   *    for (std::size_t i=0; i<chunk.num_entries; ++i) sum += mass[i];
+   *  });
+   *  @endcode
+   *
+   *  @param chunk_size number of tree entries per chunk
+   *  @param callback function called for each chunk in entry order
+   *  @param cut optional RooFormula cut applied in addition to the range cuts
+   */
+  void ForEachChunk(std::size_t chunk_size, 
+                    const std::function<void(const TupleChunk&)>& callback,
+                    const std::string& cut="");
+
+  /**
+   *  @brief Convert tree into a compact column store keeping branch types
+   *
+   *  All variables in the internal argset available in the tree are read 
+   *  into a CompactColumnStore with range cuts and the optional @a cut 
+   *  applied. The cut is evaluated as RooFormula as in ConvertToDataSet().
+   *  In contrast to ConvertToDataSet(), values keep the storage type
+   *  of their branches (e.g. 4 bytes for @c Float_t) and categories are 
+   *  stored as 8 bit codes. RooFormulaVars are not evaluated. A RooDataSet 
+   *  for fitting can be created from the store when needed via 
+   *  CompactColumnStore::CreateDataSet().
+   *
+   *  The tree is streamed in chunks (see ForEachChunk()), so no double 
+   *  precision copy of the whole tree is held at any time.
+   *
+   *  @param cut optional RooFormula cut applied in addition to the range cuts
+   *  @return the converted compact store
+   */
+  const CompactColumnStore& ConvertToCompactStore(const std::string& cut="");
+
+  /**
+   *  @brief Get previously converted compact column store
+   *
+   *  @return the CompactColumnStore reference
+   */
+  const CompactColumnStore& compact_store() const {return *compact_store_;}
+
+  /**
+   *  @brief Fill tree directly into a binned RooDataHist
+   *
+   *  All variables in the internal argset available in the tree are binned 
+   *  with their default binning (set via RooRealVar::setBins() or 
+   *  RooRealVar::setBinning()), categories with one bin per state. Range 
+   *  cuts and the optional @a cut are applied as in ConvertToDataSet(), the
+   *  cut is evaluated as RooFormula on the imported values. 
+   *  Entries are counted while streaming the tree, so memory scales with the
+   *  number of bins instead of the number of entries. RooFormulaVars are not
+   *  evaluated. Variables without a finite range cause an exception, entries
+   *  with non-finite values are skipped.
+   *
+   *  With set_num_threads(), tuples opened from file(s) are filled by worker
+   *  threads with their own bin counts which are added up afterwards.
+   *
+   *  @code
+   *  varMass.setBins(200);
+   *  EasyTuple etuple("tuplefile.root", "Bs2Jpsif0", RooArgSet(varMass,catTag));
+   *  etuple.set_num_threads(4);
+   *  RooDataHist& data = etuple.ConvertToDataHist("catTag==catTag::tagged");
+   *  @endcode
+   *
+   *  @param cut optional RooFormula cut applied in addition to the range cuts
+   *  @return the filled RooDataHist
+   */
+  RooDataHist& ConvertToDataHist(const std::string& cut="");
+
+  /**
+   *  @brief Get previously filled RooDataHist
+   *
+   *  @return the RooDataHist reference
+   */
+  RooDataHist& datahist() {return *datahist_;}
+
+  /**
+   *  @brief Get I/O statistics accumulated over all conversions of this tuple
+   *
+   *  Covers ConvertToDataSet() (unless loaded from a snapshot) and 
+   *  ForEachChunk() (including ConvertToCompactStore()).
+   *
+   *  @return the accumulated IOStatistics
+   */
+  const IOStatistics& io_statistics() const {return io_statistics_;}
  
   /**
    *  @brief Set maximum number of events to process in tree
@@ -287,26 +654,202 @@ class EasyTuple {
    *  @param cut_variable_range cut mode for variable ranges
    */
   void set_cut_variable_range(VariableRangeCutting cut_variable_range) { cut_variable_range_ = cut_variable_range; }
+
+  /**
+   *  @brief Set directory for the dataset snapshot cache
+   *
+   *  If a cache directory is set, ConvertToDataSet() will store the converted
+   *  dataset as column snapshot (see doocore::io::SnapshotCache) in this 
+   *  directory. Subsequent conversions with identical source file (path and 
+   *  modification time), variables (including ranges and category states), 
+   *  cuts and maximum number of events will load the snapshot instead of 
+   *  reading the TTree. An empty string disables the cache (default).
+   *
+   *  Conversions with additional RooCmdArgs besides Cut() are never cached.
+   *
+   *  @param cache_directory directory for snapshot files
+   */
+  void set_cache_directory(const std::string& cache_directory) { cache_directory_ = cache_directory; }
+
+  /**
+   *  @brief Set directory for entry list sidecar files
+   *
+   *  If an entry list directory is set, ConvertToDataSet() stores the numbers
+   *  of all tree entries passing the cuts (see doocore::io::EntryListCache). 
+   *  Subsequent conversions with identical source file (path and modification
+   *  time), final cut string, variable ranges (which are applied even with 
+   *  kNoCuts), category states and maximum number of events only read these 
+   *  entries and skip the evaluation of the cut. In contrast to 
+   *  set_cache_directory(), formula variables may differ between runs.
+   *  An empty string disables entry lists (default).
+   *
+   *  Conversions with additional RooCmdArgs besides Cut() never use entry 
+   *  lists.
+   *
+   *  @param entry_list_directory directory for entry list files
+   */
+  void set_entry_list_directory(const std::string& entry_list_directory) { entry_list_directory_ = entry_list_directory; }
+
+  /**
+   *  @brief Set number of worker threads for conversion
+   *
+   *  With more than one thread, ConvertToDataSet() splits the tree into 
+   *  disjoint entry ranges. Each worker opens its own TFile and TTree (or 
+   *  TChain for a chain of files), applies the same branch selection as the 
+   *  constructor and evaluates the cuts. The results are merged into one RooDataSet in the original entry order.
+   *
+   *  Parallel conversion is only possible for tuples opened from file(s) and 
+   *  without RooCmdArgs besides Cut(). Otherwise, conversion falls back to 
+   *  one thread.
+   *
+   *  @param num_threads number of worker threads (default: 1)
+   */
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+
+  /**
+   *  @brief Convert only a random subsample of whole tree clusters
+   *
+   *  Instead of truncating the tree like set_num_maximum_events(), each TTree
+   *  cluster (a range of entries stored together in baskets) is accepted 
+   *  with probability @a fraction. Only accepted clusters are read, so the I/O
+   *  cost scales with the fraction. The selection is reproducible for a fixed
+   *  seed. Entries within a cluster are kept or dropped together, so the 
+   *  subsample is unbiased but not independent entry by entry.
+   *
+   *  Subsampling applies to ConvertToDataSet(), ForEachChunk(), 
+   *  ConvertToCompactStore(), ConvertToDataHist(), Column() and Columns(). 
+   *  ConvertToDataSet() with RooCmdArgs besides Cut() reads all entries and 
+   *  warns. A fraction of 1 disables subsampling.
+   *
+   *  @param fraction fraction of clusters to read (0 < fraction <= 1)
+   *  @param seed seed for the random cluster selection
+   */
+  void set_subsample_fraction(double fraction, unsigned int seed=4357) { subsample_fraction_ = fraction; subsample_seed_ = seed; }
  
  protected:
   
  private:
   /**
-   *  @brief Internal TFile pointer
+   *  @brief Check if a tree is available and throw otherwise
+   */
+  void CheckTree() const;
+
+  /**
+   *  @brief Select the entries of the subsample (see set_subsample_fraction())
+   *
+   *  @param entries selected global entry numbers in ascending order
+   *  @return whether subsampling is enabled
+   */
+  bool SubsampledEntries(std::vector<Long64_t>& entries) const;
+
+  /**
+   *  @brief Deactivate all branches not in internal argset
+   *
+   *  Sets the branch status of the internal tree and stores the names of all
+   *  activated branches.
+   */
+  void ActivateBranches();
+
+  /**
+   *  @brief Convert the tree natively without RooFit's tree import
+   *
+   *  Branches are read in their native types. Variable range cuts are 
+   *  applied as compiled comparisons while reading, the user cut is then 
+   *  evaluated as RooFormula on the imported values. If more than one thread
+   *  is configured, the tree is split into entry ranges converted by worker
+   *  threads.
+   *
+   *  If an entry list key is supplied, a stored entry list is used to read 
+   *  only passing entries or, if none exists, the passing entries are stored.
+   *
+   *  Formula variables that can be compiled (see FormulaKernel) are evaluated
+   *  in batches on the imported columns and removed from @a formulas, the 
+   *  remaining ones have to be added via RooDataSet::addColumn().
+   *
+   *  @param argset the RooArgSet used for conversion (without formulas)
+   *  @param user_cut_string the user-supplied cut (without range cuts)
+   *  @param entry_list_key key for entry list sidecar (empty if disabled)
+   *  @param statistics statistics to add the conversion's counters and timers to
+   *  @param formulas formula variables to add as columns
+   *  @return the converted dataset
+   */
+  RooDataSet* ConvertNative(const RooArgSet& argset, const std::string& user_cut_string,
+                            const std::string& entry_list_key, IOStatistics& statistics,
+                            std::vector<RooFormulaVar*>& formulas);
+
+  /**
+   *  @brief Build the snapshot cache key for a conversion
+   *
+   *  @param argset the RooArgSet used for conversion
+   *  @param cut_string the final cut string used for conversion
+   *  @return key string or empty string if the source cannot be identified
+   */
+  std::string SnapshotKey(const RooArgSet& argset, const std::string& cut_string) const;
+
+  /**
+   *  @brief Build the entry list key for a conversion
+   *
+   *  @param argset the RooArgSet used for conversion
+   *  @param cut_string the final cut string used for conversion
+   *  @return key string or empty string if the source cannot be identified
+   */
+  std::string EntryListKey(const RooArgSet& argset, const std::string& cut_string) const;
+
+  /**
+   *  @brief Build the part of cache keys identifying the source files and tree
+   *
+   *  @return key string or empty string if not all source files are local
+   */
+  std::string SourceKey() const;
+
+  /**
+   *  @brief Open internal TFile and TTree from first entry of file_names_
+   */
+  void OpenFile();
+
+  /**
+   *  @brief Build internal TChain from file_names_
    */
-  TFile* file_;
+  void OpenChain();
+
+  /**
+   *  @brief Delete internal TTree, TFile and TChain (if owned)
+   */
+  void CloseTree();
+
+  /**
+   *  @brief Copy internal RooDataSet if shared with other EasyTuples
+   */
+  void DetachDataSet();
+
   /**
-   *  @brief Internal TTree pointer
+   *  @brief Internal TFile (empty if not reading a single file)
+   */
+  std::unique_ptr<TFile> file_;
+  /**
+   *  @brief Internal TChain (empty if not reading a chain of files)
+   */
+  std::unique_ptr<TChain> chain_;
+  /**
+   *  @brief Internal TTree pointer (owned by file_ or chain_ if these are set)
    */
   TTree* tree_;
   /**
-   *  @brief Internal RooArgSet pointer
+   *  @brief Internal RooArgSet
+   */
+  std::unique_ptr<RooArgSet> argset_;
+  /**
+   *  @brief Internal RooDataSet, shared between copies until modified
    */
-  RooArgSet* argset_;
+  std::shared_ptr<RooDataSet> dataset_;
   /**
-   *  @brief Internal RooDataSet pointer
+   *  @brief Compact column store, shared between copies
    */
-  RooDataSet* dataset_;
+  std::shared_ptr<const CompactColumnStore> compact_store_;
+  /**
+   *  @brief Binned dataset from ConvertToDataHist(), shared between copies
+   */
+  std::shared_ptr<RooDataHist> datahist_;
   /**
    *  @brief Tree name in TFile for copying
    */
@@ -321,6 +864,46 @@ class EasyTuple {
    *  @brief Cut mode for variable ranges
    **/
   VariableRangeCutting cut_variable_range_;
+
+  /**
+   *  @brief Directory for dataset snapshots (empty if disabled)
+   **/
+  std::string cache_directory_;
+
+  /**
+   *  @brief Directory for entry list sidecar files (empty if disabled)
+   **/
+  std::string entry_list_directory_;
+
+  /**
+   *  @brief Number of worker threads for conversion
+   **/
+  int num_threads_;
+
+  /**
+   *  @brief Fraction of clusters to read (1 if not subsampling)
+   **/
+  double subsample_fraction_;
+
+  /**
+   *  @brief Seed for random cluster selection
+   **/
+  unsigned int subsample_seed_;
+
+  /**
+   *  @brief Names of branches activated in the tree
+   **/
+  std::vector<std::string> active_branches_;
+
+  /**
+   *  @brief Names of files the tree is read from (empty for external trees)
+   **/
+  std::vector<std::string> file_names_;
+
+  /**
+   *  @brief I/O statistics accumulated over all conversions
+   **/
+  IOStatistics io_statistics_;
 }; // class EasyTuple
 } // namespace utils
 } // namespace doofit
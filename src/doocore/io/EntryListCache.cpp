@@ -0,0 +1,123 @@
+#include "doocore/io/EntryListCache.h"
+
+// from STL
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <iomanip>
+
+// POSIX/UNIX
+#include <unistd.h>
+
+// from BOOST
+#include <boost/filesystem.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/Tools.h"
+
+namespace {
+/// magic string and version at the beginning of each entry list file
+const char kEntryListMagic[8] = {'D','C','E','L','S','T','0','1'};
+} // namespace
+
+doocore::io::EntryListCache::EntryListCache(const std::string& cache_directory)
+: cache_directory_(cache_directory)
+{}
+
+std::string doocore::io::EntryListCache::FileName(const std::string& key) const {
+  std::stringstream file_name;
+  file_name << std::hex << std::setw(16) << std::setfill('0') << doocore::io::tools::HashString(key) << ".dcelist";
+  return (boost::filesystem::path(cache_directory_) / file_name.str()).string();
+}
+
+bool doocore::io::EntryListCache::Load(const std::string& key, Long64_t num_entries, std::vector<Long64_t>& entries) const {
+  std::string   file_name = FileName(key);
+  std::ifstream stream(file_name.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open()) return false;
+
+  char               magic[8];
+  unsigned long long length_key = 0, stored_entries = 0, num_passed = 0;
+  std::string        stored_key;
+  stream.read(magic, sizeof(magic));
+  stream.read(reinterpret_cast<char*>(&length_key), sizeof(length_key));
+  if (stream && std::memcmp(magic, kEntryListMagic, sizeof(magic)) == 0 && length_key == key.length()) {
+    stored_key.resize(length_key);
+    stream.read(&stored_key[0], length_key);
+  }
+  stream.read(reinterpret_cast<char*>(&stored_entries), sizeof(stored_entries));
+  stream.read(reinterpret_cast<char*>(&num_passed), sizeof(num_passed));
+
+  std::vector<unsigned char> bitmap((num_entries+7)/8);
+  if (stream && stored_key == key && stored_entries == static_cast<unsigned long long>(num_entries)) {
+    stream.read(reinterpret_cast<char*>(bitmap.data()), bitmap.size());
+  }
+  if (!stream || stored_key != key || stored_entries != static_cast<unsigned long long>(num_entries)) {
+    swarn << "EntryListCache::Load(...): Entry list " << file_name << " is invalid or does not match the requested key. Ignoring entry list." << endmsg;
+    return false;
+  }
+
+  entries.clear();
+  entries.reserve(num_passed);
+  for (std::size_t i=0; i<bitmap.size(); ++i) {
+    if (bitmap[i] == 0) continue;
+    for (int bit=0; bit<8; ++bit) {
+      if (bitmap[i] & (1 << bit)) entries.push_back(static_cast<Long64_t>(i)*8+bit);
+    }
+  }
+  return entries.size() == num_passed;
+}
+
+bool doocore::io::EntryListCache::Save(const std::string& key, Long64_t num_entries, const std::vector<Long64_t>& entries) const {
+  namespace fs = boost::filesystem;
+
+  std::vector<unsigned char> bitmap((num_entries+7)/8, 0);
+  for (std::vector<Long64_t>::const_iterator it = entries.begin(), end = entries.end();
+       it != end; ++it) {
+    if (*it < 0 || *it >= num_entries) {
+      swarn << "EntryListCache::Save(...): Entry " << *it << " out of range. Entry list will not be stored." << endmsg;
+      return false;
+    }
+    bitmap[*it/8] |= static_cast<unsigned char>(1 << (*it%8));
+  }
+
+  try {
+    if (!fs::exists(cache_directory_)) fs::create_directories(cache_directory_);
+  } catch (const fs::filesystem_error& e) {
+    swarn << "EntryListCache::Save(...): Cannot create cache directory " << cache_directory_ << ": " << e.what() << endmsg;
+    return false;
+  }
+
+  std::string file_name = FileName(key);
+  std::stringstream temp_name;
+  temp_name << file_name << ".tmp" << getpid();
+
+  std::ofstream stream(temp_name.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!stream.is_open()) {
+    swarn << "EntryListCache::Save(...): Cannot write entry list " << temp_name.str() << "." << endmsg;
+    return false;
+  }
+
+  unsigned long long length_key = key.length();
+  unsigned long long total      = num_entries;
+  unsigned long long num_passed = entries.size();
+  stream.write(kEntryListMagic, sizeof(kEntryListMagic));
+  stream.write(reinterpret_cast<const char*>(&length_key), sizeof(length_key));
+  stream.write(key.data(), length_key);
+  stream.write(reinterpret_cast<const char*>(&total), sizeof(total));
+  stream.write(reinterpret_cast<const char*>(&num_passed), sizeof(num_passed));
+  stream.write(reinterpret_cast<const char*>(bitmap.data()), bitmap.size());
+  stream.close();
+
+  if (stream.fail() || std::rename(temp_name.str().c_str(), file_name.c_str()) != 0) {
+    swarn << "EntryListCache::Save(...): Writing entry list " << file_name << " failed." << endmsg;
+    std::remove(temp_name.str().c_str());
+    return false;
+  }
+
+  sinfo << "EntryListCache::Save(...): Stored " << num_passed << " of " << num_entries << " entries in entry list " << file_name << endmsg;
+  return true;
+}
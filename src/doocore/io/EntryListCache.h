@@ -0,0 +1,106 @@
+#ifndef DOOCORE_IO_ENTRYLISTCACHE_H
+#define DOOCORE_IO_ENTRYLISTCACHE_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+#include "Rtypes.h"
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::EntryListCache
+ * @brief On-disk cache of tree entries passing a selection
+ *
+ * EntryListCache stores the numbers of all tree entries passing a selection
+ * as compact bitmap (one bit per tree entry) in a sidecar file inside a cache
+ * directory. As for SnapshotCache, each entry list is identified by a key
+ * string that has to describe the source tree and the complete selection. The
+ * file name is derived from a hash of the key, the full key is stored in the
+ * file and checked on loading.
+ *
+ * With a stored entry list, subsequent reads of the same selection only need
+ * to read the passing entries. For tight selections this skips most of the
+ * I/O.
+ *
+ * @section elc_usage Usage
+ *
+ * EntryListCache is normally used through
+ * doocore::io::EasyTuple::set_entry_list_directory(), but can be used
+ * standalone:
+ *
+ * @code
+ * EntryListCache cache("/tmp/entry_lists");
+ * std::vector<Long64_t> entries;
+ * if (!cache.Load(key, tree.GetEntries(), entries)) {
+ *   entries = ...; // evaluate selection on all entries
+ *   cache.Save(key, tree.GetEntries(), entries);
+ * }
+ * @endcode
+ */
+class EntryListCache {
+ public:
+  /**
+   *  @brief Constructor for EntryListCache
+   *
+   *  The cache directory will be created on first use if not existing.
+   *
+   *  @param cache_directory directory to store entry list files in
+   */
+  EntryListCache(const std::string& cache_directory);
+
+  /**
+   *  @brief Load entry list for a given key
+   *
+   *  @param key key string identifying the entry list
+   *  @param num_entries total number of entries in the tree (has to match the stored list)
+   *  @param entries vector to fill with the passing entry numbers in ascending order
+   *  @return whether a valid entry list was found
+   */
+  bool Load(const std::string& key, Long64_t num_entries, std::vector<Long64_t>& entries) const;
+
+  /**
+   *  @brief Save entry list for a given key
+   *
+   *  The entry list is written to a temporary file first and moved into place
+   *  afterwards so that concurrent jobs will never read incomplete lists.
+   *
+   *  @param key key string identifying the entry list
+   *  @param num_entries total number of entries in the tree
+   *  @param entries passing entry numbers (each smaller than num_entries)
+   *  @return whether the entry list could be stored
+   */
+  bool Save(const std::string& key, Long64_t num_entries, const std::vector<Long64_t>& entries) const;
+
+  /**
+   *  @brief Get file name of entry list for a given key
+   *
+   *  @param key key string identifying the entry list
+   *  @return file name of entry list in cache directory
+   */
+  std::string FileName(const std::string& key) const;
+
+ protected:
+
+ private:
+  /**
+   *  @brief Directory for entry list files
+   */
+  std::string cache_directory_;
+}; // class EntryListCache
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_ENTRYLISTCACHE_H
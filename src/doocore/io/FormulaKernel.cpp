@@ -0,0 +1,209 @@
+#include "doocore/io/FormulaKernel.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+
+// from ROOT
+#include "RVersion.h"
+#include "TInterpreter.h"
+
+// from RooFit
+#include "RooFormulaVar.h"
+#include "RooAbsArg.h"
+
+// from BOOST
+#include <boost/thread.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/Tools.h"
+
+namespace {
+/**
+ *  @brief Mutex protecting the interpreter and the kernel cache
+ */
+boost::mutex mutex_kernels;
+
+/**
+ *  @brief Compiled kernels by name (NULL for failed compilations)
+ */
+std::map<std::string, void*>& KernelCache() {
+  static std::map<std::string, void*> cache;
+  return cache;
+}
+
+/**
+ *  @brief Math functions translated to their std:: counterparts
+ */
+const char* const kStdFunctions[] = {"sqrt", "exp", "log", "log10", "pow", "abs", "fabs",
+                                     "sin", "cos", "tan", "asin", "acos", "atan", "atan2",
+                                     "sinh", "cosh", "tanh", "floor", "ceil", NULL};
+} // namespace
+
+doocore::io::FormulaKernel::FormulaKernel(const std::string& expression, const std::vector<std::string>& dependents)
+: expression_(expression),
+  dependents_(dependents),
+  function_(NULL)
+{
+  Compile();
+}
+
+doocore::io::FormulaKernel::FormulaKernel(const RooFormulaVar& formula)
+: function_(NULL)
+{
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,22,0)
+  expression_ = formula.expression();
+#else
+  // no accessor for the expression, the formula stays uncompiled
+  return;
+#endif
+
+  for (int i=0; formula.getParameter(i) != NULL; ++i) {
+    dependents_.push_back(formula.getParameter(i)->GetName());
+  }
+  Compile();
+}
+
+void doocore::io::FormulaKernel::Evaluate(const std::vector<const double*>& inputs, double* output, std::size_t num_entries) const {
+  function_(inputs.data(), output, num_entries);
+}
+
+bool doocore::io::FormulaKernel::TranslateExpression(std::string& cpp_expression) const {
+  const std::string& e = expression_;
+  std::size_t        n = e.length();
+  std::stringstream  cpp;
+  for (std::size_t i=0; i<n; ) {
+    unsigned char c = e[i];
+    if (std::isspace(c)) {
+      cpp << c;
+      ++i;
+    } else if (c == '@') {
+      // positional reference @k
+      std::size_t j = i+1;
+      while (j<n && std::isdigit(static_cast<unsigned char>(e[j]))) ++j;
+      if (j == i+1) return false;
+      std::size_t k = std::atoi(e.substr(i+1, j-i-1).c_str());
+      if (k >= dependents_.size()) return false;
+      cpp << "x[" << k << "][i]";
+      i = j;
+    } else if (std::isdigit(c) || (c == '.' && i+1<n && std::isdigit(static_cast<unsigned char>(e[i+1])))) {
+      // numeric literal including exponent, always double as in TFormula 
+      // (i.e. 1/2 is 0.5 and 010 is 10, not octal)
+      std::size_t j          = i;
+      int         num_points = 0;
+      while (j<n && (std::isdigit(static_cast<unsigned char>(e[j])) || e[j] == '.')) {
+        if (e[j] == '.') ++num_points;
+        ++j;
+      }
+      if (num_points > 1) return false;
+      std::size_t mantissa_end = j;
+      if (j<n && (e[j] == 'e' || e[j] == 'E')) {
+        std::size_t k = j+1;
+        if (k<n && (e[k] == '+' || e[k] == '-')) ++k;
+        if (k<n && std::isdigit(static_cast<unsigned char>(e[k]))) {
+          j = k;
+          while (j<n && std::isdigit(static_cast<unsigned char>(e[j]))) ++j;
+        }
+      }
+      std::string mantissa = e.substr(i, mantissa_end-i);
+      mantissa.erase(0, mantissa.find_first_not_of('0'));
+      if (mantissa.length() == 0 || mantissa[0] == '.') mantissa.insert(0, "0");
+      if (num_points == 0) mantissa += ".";
+      cpp << mantissa << e.substr(mantissa_end, j-mantissa_end);
+      i = j;
+    } else if (std::isalpha(c) || c == '_') {
+      // identifier, possibly scoped
+      std::size_t j = i;
+      while (j<n) {
+        if (std::isalnum(static_cast<unsigned char>(e[j])) || e[j] == '_') {
+          ++j;
+        } else if (e[j] == ':' && j+1<n && e[j+1] == ':') {
+          j += 2;
+        } else {
+          break;
+        }
+      }
+      std::string identifier = e.substr(i, j-i);
+      i = j;
+
+      bool found = false;
+      for (std::size_t k=0; k<dependents_.size() && !found; ++k) {
+        if (dependents_[k] == identifier) {
+          cpp << "x[" << k << "][i]";
+          found = true;
+        }
+      }
+      for (int k=0; kStdFunctions[k] != NULL && !found; ++k) {
+        if (identifier == kStdFunctions[k]) {
+          cpp << "std::" << identifier;
+          found = true;
+        }
+      }
+      if (!found && identifier.compare(0, 7, "TMath::") == 0 && identifier.find("::", 7) == std::string::npos) {
+        cpp << identifier;
+        found = true;
+      } else if (!found && (identifier == "min" || identifier == "max")) {
+        cpp << (identifier == "min" ? "TMath::Min" : "TMath::Max");
+        found = true;
+      }
+      // e.g. category states or unknown functions
+      if (!found) return false;
+    } else if (std::strchr("+-*/()<>=!&|,?:", c) != NULL) {
+      cpp << c;
+      ++i;
+    } else {
+      return false;
+    }
+  }
+  cpp_expression = cpp.str();
+  return true;
+}
+
+void doocore::io::FormulaKernel::Compile() {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  std::string cpp_expression;
+  if (expression_.length() == 0 || !TranslateExpression(cpp_expression)) return;
+
+  std::stringstream name;
+  name << "kernel_" << std::hex << doocore::io::tools::HashString(cpp_expression);
+
+  boost::mutex::scoped_lock lock(mutex_kernels);
+  std::map<std::string, void*>&                cache = KernelCache();
+  std::map<std::string, void*>::const_iterator it    = cache.find(name.str());
+  if (it != cache.end()) {
+    function_ = reinterpret_cast<KernelFunction>(it->second);
+    return;
+  }
+
+  std::stringstream code;
+  code << "#pragma cling optimize(3)\n"
+       << "#include <cmath>\n"
+       << "#include \"TMath.h\"\n"
+       << "namespace doocore_formula_kernels {\n"
+       << "void " << name.str() << "(const double* const* x, double* y, unsigned long n) {\n"
+       << "  for (unsigned long i=0; i<n; ++i) y[i] = (" << cpp_expression << ");\n"
+       << "}\n"
+       << "}\n";
+
+  void* function = NULL;
+  if (gInterpreter->Declare(code.str().c_str())) {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,26,0)
+    std::string address = "(Longptr_t)&doocore_formula_kernels::" + name.str();
+#else
+    std::string address = "(Long_t)&doocore_formula_kernels::" + name.str();
+#endif
+    function = reinterpret_cast<void*>(gInterpreter->Calc(address.c_str()));
+  }
+  if (function == NULL) {
+    swarn << "FormulaKernel: Cannot compile formula '" << expression_ << "'." << endmsg;
+  }
+  cache[name.str()] = function;
+  function_ = reinterpret_cast<KernelFunction>(function);
+#endif
+}
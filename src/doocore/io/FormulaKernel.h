@@ -0,0 +1,141 @@
+#ifndef DOOCORE_IO_FORMULAKERNEL_H
+#define DOOCORE_IO_FORMULAKERNEL_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class RooFormulaVar;
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::FormulaKernel
+ * @brief Compiled batch evaluation of RooFormulaVar expressions
+ *
+ * FormulaKernel translates a formula expression into a C++ loop over arrays
+ * of input values, compiles it once via the interpreter (Cling) and evaluates
+ * it on whole columns instead of one event at a time. Kernels are cached per
+ * process, so identical formulas are compiled only once.
+ *
+ * Inputs are referenced as in RooFormulaVar, either by @c @@k or by the name
+ * of the k-th dependent. Only expressions made of numbers, operators, the
+ * dependents and common math functions (e.g. @c sqrt, @c exp, @c TMath::...)
+ * are translated. Anything else (e.g. category state names or @c ^ for powers)
+ * leaves the kernel uncompiled, in which case the caller has to fall back to
+ * RooFit's per-event evaluation. Numeric literals are always treated as 
+ * floating point numbers like in TFormula, so @c 1/2 evaluates to 0.5. 
+ * Kernels are never compiled with ROOT 5.
+ *
+ * @section fk_usage Usage
+ *
+ * @code
+ * RooFormulaVar pt("pt", "pt", "sqrt(px*px+py*py)", RooArgList(px, py));
+ * FormulaKernel kernel(pt);
+ * if (kernel.IsCompiled()) {
+ *   std::vector<const double*> inputs = {px_values.data(), py_values.data()};
+ *   kernel.Evaluate(inputs, pt_values.data(), px_values.size());
+ * }
+ * @endcode
+ */
+class FormulaKernel {
+ public:
+  /**
+   *  @brief Constructor for FormulaKernel from an expression
+   *
+   *  @param expression formula expression in RooFormulaVar syntax
+   *  @param dependents names of the dependents (in order of @c @@k)
+   */
+  FormulaKernel(const std::string& expression, const std::vector<std::string>& dependents);
+
+  /**
+   *  @brief Constructor for FormulaKernel from a RooFormulaVar
+   *
+   *  The expression is only accessible from ROOT 6.22 on. With older 
+   *  versions, the kernel stays uncompiled.
+   *
+   *  @param formula RooFormulaVar to take expression and dependents from
+   */
+  FormulaKernel(const RooFormulaVar& formula);
+
+  /**
+   *  @brief Check whether the expression could be translated and compiled
+   *
+   *  @return whether Evaluate() can be used
+   */
+  bool IsCompiled() const { return function_ != NULL; }
+
+  /**
+   *  @brief Evaluate formula on arrays of input values
+   *
+   *  @param inputs one array per dependent with at least num_entries values each
+   *  @param output array for num_entries results
+   *  @param num_entries number of entries to evaluate
+   */
+  void Evaluate(const std::vector<const double*>& inputs, double* output, std::size_t num_entries) const;
+
+  /**
+   *  @brief Get names of dependents
+   *
+   *  @return names of dependents (in order of inputs for Evaluate())
+   */
+  const std::vector<std::string>& dependents() const { return dependents_; }
+
+  /**
+   *  @brief Get formula expression
+   *
+   *  @return the expression in RooFormulaVar syntax
+   */
+  const std::string& expression() const { return expression_; }
+
+ protected:
+
+ private:
+  /**
+   *  @brief Signature of compiled kernels
+   */
+  typedef void (*KernelFunction)(const double* const*, double*, unsigned long);
+
+  /**
+   *  @brief Translate expression into C++ with inputs as x[k][i]
+   *
+   *  @param cpp_expression translated expression
+   *  @return whether the expression could be translated
+   */
+  bool TranslateExpression(std::string& cpp_expression) const;
+
+  /**
+   *  @brief Translate and compile the expression (or get it from the cache)
+   */
+  void Compile();
+
+  /**
+   *  @brief Formula expression
+   */
+  std::string expression_;
+
+  /**
+   *  @brief Names of dependents
+   */
+  std::vector<std::string> dependents_;
+
+  /**
+   *  @brief Compiled kernel (NULL if not compiled)
+   */
+  KernelFunction function_;
+}; // class FormulaKernel
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_FORMULAKERNEL_H
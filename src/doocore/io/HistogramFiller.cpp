@@ -0,0 +1,252 @@
+#include "doocore/io/HistogramFiller.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+
+// from ROOT
+#include "TTree.h"
+#include "TChain.h"
+#include "TTreeFormula.h"
+#include "TH1.h"
+#include "TH2.h"
+
+// from BOOST
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/EasyTuple.h"
+#include "doocore/io/Tools.h"
+
+namespace {
+/**
+ *  @brief Mutex for non-threadsafe setup of ROOT objects in threads
+ */
+boost::mutex mutex_filler_setup;
+
+/**
+ *  @brief Position of the colon separating y and x in "y:x" (npos if none)
+ *
+ *  Double colons (as in C++ scope operators) are not treated as separator.
+ */
+std::size_t FindAxisSeparator(const std::string& expression) {
+  for (std::size_t i=0; i<expression.length(); ++i) {
+    if (expression[i] != ':') continue;
+    if (i+1 < expression.length() && expression[i+1] == ':') {
+      ++i;
+      continue;
+    }
+    return i;
+  }
+  return std::string::npos;
+}
+
+/**
+ *  @brief Get index of a formula in a list, compiling it if not yet existing
+ */
+int FormulaIndex(const std::string& expression, TTree& tree,
+                 std::vector<std::string>& expressions,
+                 std::vector<std::unique_ptr<TTreeFormula> >& formulas) {
+  using namespace doocore::io;
+  if (expression.length() == 0) return -1;
+  for (std::size_t i=0; i<expressions.size(); ++i) {
+    if (expressions[i] == expression) return i;
+  }
+
+  std::stringstream name;
+  name << "doocore_histogram_formula_" << formulas.size();
+  formulas.push_back(std::unique_ptr<TTreeFormula>(new TTreeFormula(name.str().c_str(), expression.c_str(), &tree)));
+  if (formulas.back()->GetNdim() == 0) {
+    serr << "HistogramFiller: Expression '" << expression << "' cannot be compiled." << endmsg;
+    throw 1;
+  }
+  expressions.push_back(expression);
+  return formulas.size()-1;
+}
+} // namespace
+
+doocore::io::HistogramFiller::HistogramFiller(TTree& tree)
+: tree_(&tree)
+{}
+
+doocore::io::HistogramFiller::HistogramFiller(const std::vector<std::string>& file_names, const std::string& tree_name)
+: tree_(NULL),
+  file_names_(file_names),
+  tree_name_(tree_name)
+{}
+
+doocore::io::HistogramFiller::HistogramFiller(EasyTuple& tuple)
+: tree_(NULL),
+  file_names_(tuple.file_names()),
+  tree_name_(tuple.tree_name())
+{
+  if (file_names_.empty()) tree_ = &tuple.tree();
+}
+
+void doocore::io::HistogramFiller::Add(TH1& histogram, const std::string& expression, const std::string& selection) {
+  Definition definition;
+  definition.histogram = &histogram;
+  definition.selection = selection;
+
+  std::size_t separator = FindAxisSeparator(expression);
+  if (separator != std::string::npos) {
+    definition.expression_y = expression.substr(0, separator);
+    definition.expression_x = expression.substr(separator+1);
+    if (dynamic_cast<TH2*>(&histogram) == NULL) {
+      serr << "HistogramFiller: Expression '" << expression << "' needs a TH2 histogram." << endmsg;
+      throw 1;
+    }
+  } else {
+    definition.expression_x = expression;
+  }
+  definitions_.push_back(definition);
+}
+
+void doocore::io::HistogramFiller::Fill(int num_threads) {
+  if (definitions_.empty()) return;
+
+  if (file_names_.empty()) {
+    if (tree_ == NULL) {
+      serr << "HistogramFiller: No tree to read from." << endmsg;
+      throw 3;
+    }
+    std::vector<TH1*> histograms;
+    for (std::vector<Definition>::const_iterator it = definitions_.begin(), end = definitions_.end();
+         it != end; ++it) {
+      histograms.push_back(it->histogram);
+    }
+    FillRange(*tree_, 0, tree_->GetEntries(), histograms);
+    return;
+  }
+
+  Long64_t num_entries = 0;
+  {
+    TChain chain(tree_name_.c_str());
+    for (std::vector<std::string>::const_iterator it = file_names_.begin(), end = file_names_.end();
+         it != end; ++it) {
+      chain.Add(it->c_str());
+    }
+    num_entries = chain.GetEntries();
+  }
+  if (num_threads < 1) num_threads = 1;
+  if (num_entries < num_threads) num_threads = num_entries > 0 ? num_entries : 1;
+  doocore::io::tools::EnableRootThreadSafety();
+
+  // histogram copies per thread, detached from any directory
+  std::vector<std::vector<TH1*> > copies(num_threads);
+  for (int t=0; t<num_threads; ++t) {
+    for (std::vector<Definition>::const_iterator it = definitions_.begin(), end = definitions_.end();
+         it != end; ++it) {
+      std::stringstream name;
+      name << it->histogram->GetName() << "_thread" << t;
+      TH1* copy = dynamic_cast<TH1*>(it->histogram->Clone(name.str().c_str()));
+      copy->SetDirectory(NULL);
+      copy->Reset();
+      copies[t].push_back(copy);
+    }
+  }
+
+  std::unique_ptr<bool[]> success(new bool[num_threads]());
+  boost::thread_group     threads;
+  for (int t=0; t<num_threads; ++t) {
+    threads.create_thread(boost::bind(&HistogramFiller::FillRangeFromFiles, this,
+                                      num_entries*t/num_threads, num_entries*(t+1)/num_threads,
+                                      &copies[t], &success[t]));
+  }
+  threads.join_all();
+
+  bool all_successful = true;
+  for (int t=0; t<num_threads; ++t) {
+    for (std::size_t i=0; i<definitions_.size(); ++i) {
+      if (success[t]) definitions_[i].histogram->Add(copies[t][i]);
+      delete copies[t][i];
+    }
+    all_successful &= success[t];
+  }
+  if (!all_successful) {
+    serr << "HistogramFiller: Filling histograms failed in at least one thread." << endmsg;
+    throw 2;
+  }
+}
+
+void doocore::io::HistogramFiller::FillRange(TTree& tree, Long64_t first_entry, Long64_t last_entry,
+                                             const std::vector<TH1*>& histograms) const {
+  if (first_entry >= last_entry || tree.LoadTree(first_entry) < 0) return;
+
+  // one formula per distinct expression or selection
+  std::vector<std::string>                   expressions;
+  std::vector<std::unique_ptr<TTreeFormula> > formulas;
+  std::vector<int>                           index_x(definitions_.size());
+  std::vector<int>                           index_y(definitions_.size());
+  std::vector<int>                           index_selection(definitions_.size());
+  {
+    boost::mutex::scoped_lock lock(mutex_filler_setup);
+    for (std::size_t i=0; i<definitions_.size(); ++i) {
+      index_x[i]         = FormulaIndex(definitions_[i].expression_x, tree, expressions, formulas);
+      index_y[i]         = FormulaIndex(definitions_[i].expression_y, tree, expressions, formulas);
+      index_selection[i] = FormulaIndex(definitions_[i].selection, tree, expressions, formulas);
+    }
+  }
+
+  std::vector<double>        values(formulas.size());
+  std::vector<unsigned char> valid(formulas.size());
+  Int_t                      tree_number = tree.GetTreeNumber();
+  for (Long64_t entry=first_entry; entry<last_entry; ++entry) {
+    if (tree.LoadTree(entry) < 0) break;
+    if (tree.GetTreeNumber() != tree_number) {
+      tree_number = tree.GetTreeNumber();
+      for (std::size_t k=0; k<formulas.size(); ++k) {
+        formulas[k]->UpdateFormulaLeaves();
+      }
+    }
+
+    for (std::size_t k=0; k<formulas.size(); ++k) {
+      valid[k] = formulas[k]->GetNdata() > 0;
+      values[k] = valid[k] ? formulas[k]->EvalInstance(0) : 0.0;
+    }
+
+    for (std::size_t i=0; i<definitions_.size(); ++i) {
+      double weight = 1.0;
+      if (index_selection[i] >= 0) {
+        if (!valid[index_selection[i]]) continue;
+        weight = values[index_selection[i]];
+        if (weight == 0.0) continue;
+      }
+      if (!valid[index_x[i]]) continue;
+      if (index_y[i] >= 0) {
+        if (!valid[index_y[i]]) continue;
+        static_cast<TH2*>(histograms[i])->Fill(values[index_x[i]], values[index_y[i]], weight);
+      } else {
+        histograms[i]->Fill(values[index_x[i]], weight);
+      }
+    }
+  }
+
+  boost::mutex::scoped_lock lock(mutex_filler_setup);
+  formulas.clear();
+}
+
+void doocore::io::HistogramFiller::FillRangeFromFiles(Long64_t first_entry, Long64_t last_entry,
+                                                      const std::vector<TH1*>* histograms, bool* success) const {
+  std::unique_ptr<TChain> chain;
+  try {
+    {
+      boost::mutex::scoped_lock lock(mutex_filler_setup);
+      chain.reset(new TChain(tree_name_.c_str()));
+      for (std::vector<std::string>::const_iterator it = file_names_.begin(), end = file_names_.end();
+           it != end; ++it) {
+        chain->Add(it->c_str());
+      }
+    }
+    FillRange(*chain, first_entry, last_entry, *histograms);
+    *success = true;
+  } catch (...) {
+    *success = false;
+  }
+  boost::mutex::scoped_lock lock(mutex_filler_setup);
+  chain.reset();
+}
@@ -0,0 +1,172 @@
+#ifndef DOOCORE_IO_HISTOGRAMFILLER_H
+#define DOOCORE_IO_HISTOGRAMFILLER_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+#include "Rtypes.h"
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class TTree;
+class TH1;
+
+namespace doocore {
+namespace io {
+
+class EasyTuple;
+
+/*! @class doocore::io::HistogramFiller
+ * @brief Fill many histograms from a tree in a single pass
+ *
+ * HistogramFiller takes a list of histogram definitions, each consisting of
+ * a histogram, an expression and an optional selection (with the same syntax
+ * as in TTree::Draw()), and fills all of them in one pass over the tree
+ * instead of one pass per histogram. Identical expressions and selections
+ * are evaluated only once per entry.
+ *
+ * The selection is used as weight as in TTree::Draw(), i.e. entries with a
+ * selection value of zero are skipped. For two-dimensional histograms, the
+ * expression is given as @c "y:x". Expressions are evaluated as scalars.
+ *
+ * If the tree is read from files, filling can be split into entry ranges on
+ * several threads. Each thread opens its own TChain and fills its own copies
+ * of the histograms, which are added to the supplied histograms at the end.
+ *
+ * @section hf_usage Usage
+ *
+ * @code
+ * TH1D h_mass("h_mass", "h_mass", 100, 5200, 5400);
+ * TH1D h_mass_tagged("h_mass_tagged", "h_mass_tagged", 100, 5200, 5400);
+ * TH2D h_time_mass("h_time_mass", "h_time_mass", 100, 5200, 5400, 100, 0, 10);
+ *
+ * HistogramFiller filler(etuple);
+ * filler.Add(h_mass, "varMass");
+ * filler.Add(h_mass_tagged, "varMass", "catTag!=0");
+ * filler.Add(h_time_mass, "varTime:varMass");
+ * filler.Fill(4);
+ * @endcode
+ */
+class HistogramFiller {
+ public:
+  /**
+   *  @brief Constructor for HistogramFiller on a given tree
+   *
+   *  Filling will be done on one thread directly on the supplied tree.
+   *
+   *  @param tree TTree or TChain to read from
+   */
+  HistogramFiller(TTree& tree);
+
+  /**
+   *  @brief Constructor for HistogramFiller on a chain of files
+   *
+   *  @param file_names files containing the tree
+   *  @param tree_name name of the tree in each file
+   */
+  HistogramFiller(const std::vector<std::string>& file_names, const std::string& tree_name);
+
+  /**
+   *  @brief Constructor for HistogramFiller on the tree of an EasyTuple
+   *
+   *  If the EasyTuple was opened from files, these files are read again
+   *  (with all branches active), otherwise its tree is used directly.
+   *
+   *  @param tuple EasyTuple to read from
+   */
+  HistogramFiller(EasyTuple& tuple);
+
+  /**
+   *  @brief Add histogram to fill
+   *
+   *  The histogram is not owned by HistogramFiller and has to exist until
+   *  Fill() is finished.
+   *
+   *  @param histogram histogram to fill (TH1 or TH2)
+   *  @param expression expression to fill (@c "y:x" for TH2)
+   *  @param selection optional selection (used as weight)
+   */
+  void Add(TH1& histogram, const std::string& expression, const std::string& selection="");
+
+  /**
+   *  @brief Fill all histograms in one pass over the tree
+   *
+   *  If an expression or selection cannot be compiled or a thread fails
+   *  reading its entries, an exception is thrown.
+   *
+   *  @param num_threads number of threads (only used for trees read from files)
+   */
+  void Fill(int num_threads=1);
+
+ protected:
+
+ private:
+  /**
+   *  @brief Histogram definition
+   */
+  struct Definition {
+    /// histogram to fill
+    TH1*        histogram;
+    /// expression for x axis
+    std::string expression_x;
+    /// expression for y axis (empty for one-dimensional histograms)
+    std::string expression_y;
+    /// selection used as weight (empty if none)
+    std::string selection;
+  };
+
+  /**
+   *  @brief Fill histograms for an entry range of a tree
+   *
+   *  @param tree tree to read from
+   *  @param first_entry first entry to read
+   *  @param last_entry entry after the last entry to read
+   *  @param histograms histograms to fill (one per definition)
+   */
+  void FillRange(TTree& tree, Long64_t first_entry, Long64_t last_entry,
+                 const std::vector<TH1*>& histograms) const;
+
+  /**
+   *  @brief Fill histograms for an entry range reading from an own TChain
+   *
+   *  @param first_entry first entry to read
+   *  @param last_entry entry after the last entry to read
+   *  @param histograms histograms to fill (one per definition)
+   *  @param success set to true if the range was filled successfully
+   */
+  void FillRangeFromFiles(Long64_t first_entry, Long64_t last_entry,
+                          const std::vector<TH1*>* histograms, bool* success) const;
+
+  /**
+   *  @brief Tree to read from (NULL if reading from files)
+   */
+  TTree* tree_;
+
+  /**
+   *  @brief Files to read from (empty if reading from tree_)
+   */
+  std::vector<std::string> file_names_;
+
+  /**
+   *  @brief Name of the tree in files
+   */
+  std::string tree_name_;
+
+  /**
+   *  @brief Histogram definitions
+   */
+  std::vector<Definition> definitions_;
+}; // class HistogramFiller
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_HISTOGRAMFILLER_H
@@ -0,0 +1,100 @@
+#include "doocore/io/IOStatistics.h"
+
+// from STL
+#include <string>
+#include <deque>
+#include <utility>
+
+// from BOOST
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ *  @brief Mutex protecting the statistics handler
+ */
+boost::mutex mutex_statistics_handler;
+
+/**
+ *  @brief Handler for statistics of finished conversions (may be empty)
+ */
+doocore::io::IOStatisticsHandler& StatisticsHandler() {
+  static doocore::io::IOStatisticsHandler handler;
+  return handler;
+}
+
+/// maximum number of statistics kept while no handler is set
+const std::size_t kMaxPendingStatistics = 1000;
+
+/**
+ *  @brief Statistics published while no handler was set (oldest first)
+ */
+std::deque<std::pair<std::string, doocore::io::IOStatistics> >& PendingStatistics() {
+  static std::deque<std::pair<std::string, doocore::io::IOStatistics> > pending;
+  return pending;
+}
+} // namespace
+
+doocore::io::IOStatistics::IOStatistics()
+: bytes_read(0),
+  bytes_decompressed(0),
+  read_calls(0),
+  entries_scanned(0),
+  entries_accepted(0),
+  time_read(0.0),
+  time_cut(0.0),
+  time_dataset_insert(0.0),
+  time_add_column(0.0),
+  time_total(0.0)
+{}
+
+doocore::io::IOStatistics& doocore::io::IOStatistics::operator+=(const IOStatistics& other) {
+  bytes_read          += other.bytes_read;
+  bytes_decompressed  += other.bytes_decompressed;
+  read_calls          += other.read_calls;
+  entries_scanned     += other.entries_scanned;
+  entries_accepted    += other.entries_accepted;
+  time_read           += other.time_read;
+  time_cut            += other.time_cut;
+  time_dataset_insert += other.time_dataset_insert;
+  time_add_column     += other.time_add_column;
+  time_total          += other.time_total;
+  return *this;
+}
+
+void doocore::io::IOStatistics::Print(MsgStream& stream) const {
+  const double megabyte = 1024.0*1024.0;
+  stream << "I/O statistics: " << bytes_read/megabyte << " MB read ("
+         << bytes_decompressed/megabyte << " MB decompressed) in " << read_calls << " read calls" << endmsg;
+  stream << "  entries scanned: " << entries_scanned << ", accepted: " << entries_accepted << endmsg;
+  stream << "  time read: " << time_read << " s";
+  if (time_read > 0.0) stream << " (" << bytes_read/megabyte/time_read << " MB/s)";
+  stream << ", cut: " << time_cut << " s, dataset insert: " << time_dataset_insert
+         << " s, addColumn: " << time_add_column << " s, total: " << time_total << " s" << endmsg;
+}
+
+void doocore::io::SetIOStatisticsHandler(const IOStatisticsHandler& handler) {
+  std::deque<std::pair<std::string, IOStatistics> > pending;
+  {
+    boost::mutex::scoped_lock lock(mutex_statistics_handler);
+    StatisticsHandler() = handler;
+    if (handler) pending.swap(PendingStatistics());
+  }
+  for (std::deque<std::pair<std::string, IOStatistics> >::const_iterator it = pending.begin(), end = pending.end();
+       it != end; ++it) {
+    handler(it->first, it->second);
+  }
+}
+
+void doocore::io::PublishIOStatistics(const std::string& task, const IOStatistics& statistics) {
+  IOStatisticsHandler handler;
+  {
+    boost::mutex::scoped_lock lock(mutex_statistics_handler);
+    handler = StatisticsHandler();
+    if (!handler) {
+      std::deque<std::pair<std::string, IOStatistics> >& pending = PendingStatistics();
+      if (pending.size() >= kMaxPendingStatistics) pending.pop_front();
+      pending.push_back(std::make_pair(task, statistics));
+    }
+  }
+  if (handler) handler(task, statistics);
+}
@@ -0,0 +1,121 @@
+#ifndef DOOCORE_IO_IOSTATISTICS_H
+#define DOOCORE_IO_IOSTATISTICS_H
+
+// from STL
+#include <string>
+#include <functional>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+#include "doocore/io/MsgStream.h"
+
+// forward declarations
+
+namespace doocore {
+namespace io {
+
+/*! @struct doocore::io::IOStatistics
+ * @brief Counters and timers of tuple reading and conversion
+ *
+ * IOStatistics collects where a conversion in doocore::io::EasyTuple spends
+ * its time: reading and decompressing the tree, evaluating cuts, inserting
+ * into the RooDataSet and adding formula columns. Comparing the read time and
+ * throughput with the CPU-side timers tells an I/O-bound conversion from a
+ * CPU-bound one.
+ *
+ * Times are given in seconds. For parallel conversions, read and cut times
+ * are summed over all threads (i.e. CPU time rather than wall time), while
+ * time_total is always the wall time of the conversion.
+ *
+ * Statistics of each conversion are accumulated in the EasyTuple (see
+ * doocore::io::EasyTuple::io_statistics()) and handed to the handler set via
+ * SetIOStatisticsHandler(). doocore::config::Summary registers such a handler,
+ * so that statistics are written to the run summary automatically. 
+ * Statistics of conversions finished before a handler is set (e.g. before 
+ * the first call of doocore::config::Summary::GetInstance()) are kept and 
+ * handed to the handler once it is set.
+ *
+ * @section ios_usage Usage
+ *
+ * @code
+ * EasyTuple etuple("tuplefile.root", "Bs2Jpsif0", RooArgSet(varMass,catTag));
+ * RooDataSet& data = etuple.ConvertToDataSet(Cut("catTag!=0"));
+ * etuple.io_statistics().Print();
+ * @endcode
+ */
+struct IOStatistics {
+  IOStatistics();
+
+  /**
+   *  @brief Add statistics of another conversion
+   */
+  IOStatistics& operator+=(const IOStatistics& other);
+
+  /**
+   *  @brief Print statistics
+   *
+   *  @param stream MsgStream to print to
+   */
+  void Print(MsgStream& stream=sinfo) const;
+
+  /// bytes read from files (compressed)
+  long long bytes_read;
+  /// bytes after decompression (estimated from the branches' compression factor)
+  long long bytes_decompressed;
+  /// number of read calls on files
+  long long read_calls;
+  /// number of tree entries looked at
+  long long entries_scanned;
+  /// number of entries passing all cuts
+  long long entries_accepted;
+  /// time reading and decompressing entries (including selections evaluated while reading)
+  double    time_read;
+  /// time evaluating the user cut and variable range cuts on read entries
+  double    time_cut;
+  /// time inserting accepted entries into the RooDataSet
+  double    time_dataset_insert;
+  /// time adding formula variables via RooDataSet::addColumn()
+  double    time_add_column;
+  /// wall time of the whole conversion
+  double    time_total;
+};
+
+/**
+ *  @brief Handler for statistics of finished conversions
+ *
+ *  The handler receives a description of the task (e.g. the EasyTuple method)
+ *  and the statistics of this task.
+ */
+typedef std::function<void(const std::string&, const IOStatistics&)> IOStatisticsHandler;
+
+/**
+ *  @brief Set handler for statistics of finished conversions
+ *
+ *  Only one handler is kept. Statistics published while no handler was set 
+ *  are handed to the new handler first (at most the last 1000). An empty 
+ *  handler disables publishing until the next handler is set.
+ *
+ *  @param handler function to call after each conversion
+ */
+void SetIOStatisticsHandler(const IOStatisticsHandler& handler);
+
+/**
+ *  @brief Hand statistics of a finished conversion to the handler
+ *
+ *  Without handler the statistics are kept until one is set.
+ *
+ *  @param task description of the task
+ *  @param statistics statistics of the task
+ */
+void PublishIOStatistics(const std::string& task, const IOStatistics& statistics);
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_IOSTATISTICS_H
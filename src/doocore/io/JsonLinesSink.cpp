@@ -0,0 +1,172 @@
+#include "doocore/io/JsonLinesSink.h"
+
+// from STL
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <chrono>
+
+// from BOOST
+#include <boost/thread/locks.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+namespace {
+/**
+ *  @brief Size of the file buffer in bytes
+ */
+const std::size_t kFileBufferSize = 1024*1024;
+
+/**
+ *  @brief Append a string to a buffer as quoted JSON string
+ */
+void AppendJsonString(const char* text, std::size_t size, std::string& buffer) {
+  buffer += '"';
+  for (std::size_t i=0; i<size; ++i) {
+    char c = text[i];
+    switch (c) {
+      case '"':  buffer += "\\\""; break;
+      case '\\': buffer += "\\\\"; break;
+      case '\n': buffer += "\\n";  break;
+      case '\r': buffer += "\\r";  break;
+      case '\t': buffer += "\\t";  break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+          buffer += escaped;
+        } else {
+          buffer += c;
+        }
+    }
+  }
+  buffer += '"';
+}
+
+/**
+ *  @brief Get name of a terminal color
+ */
+const char* ColorName(doocore::io::TerminalColor color) {
+  switch (color) {
+    case doocore::io::kTextBlack:   return "black";
+    case doocore::io::kTextRed:     return "red";
+    case doocore::io::kTextGreen:   return "green";
+    case doocore::io::kTextYellow:  return "yellow";
+    case doocore::io::kTextBlue:    return "blue";
+    case doocore::io::kTextMagenta: return "magenta";
+    case doocore::io::kTextCyan:    return "cyan";
+    case doocore::io::kTextWhite:   return "white";
+    default:                        return "none";
+  }
+}
+
+/**
+ *  @brief Append a time as ISO 8601 UTC string with microseconds
+ */
+void AppendTime(const std::chrono::system_clock::time_point& time, std::string& buffer) {
+  long long   microseconds = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+  std::time_t seconds      = static_cast<std::time_t>(microseconds/1000000);
+  std::tm     utc;
+  gmtime_r(&seconds, &utc);
+
+  char formatted[40];
+  std::size_t length = std::strftime(formatted, sizeof(formatted), "%Y-%m-%dT%H:%M:%S", &utc);
+  std::snprintf(formatted+length, sizeof(formatted)-length, ".%06lldZ", microseconds%1000000);
+  buffer += '"';
+  buffer += formatted;
+  buffer += '"';
+}
+} // namespace
+
+doocore::io::JsonLinesSink::JsonLinesSink(const std::string& file_name, std::size_t max_file_size, int max_backups)
+: file_name_(file_name),
+  max_file_size_(max_file_size),
+  max_backups_(max_backups),
+  file_(NULL),
+  buffer_(kFileBufferSize),
+  file_size_(0)
+{
+  Open();
+  if (file_ == NULL) {
+    serr << "JsonLinesSink: Cannot open log file " << file_name << "." << endmsg;
+    throw 1;
+  }
+}
+
+doocore::io::JsonLinesSink::~JsonLinesSink() {
+  if (file_ != NULL) std::fclose(file_);
+}
+
+void doocore::io::JsonLinesSink::Write(const MsgRecord& record) {
+  std::string line = FormatRecord(record);
+  line += '\n';
+
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  if (file_ == NULL) return;
+  if (max_file_size_ > 0 && file_size_ > 0 && file_size_+line.size() > max_file_size_) {
+    Rotate();
+    if (file_ == NULL) return;
+  }
+  std::fwrite(line.data(), 1, line.size(), file_);
+  file_size_ += line.size();
+}
+
+void doocore::io::JsonLinesSink::Flush() {
+  boost::lock_guard<boost::mutex> lock(mutex_);
+  if (file_ != NULL) std::fflush(file_);
+}
+
+std::string doocore::io::JsonLinesSink::FormatRecord(const MsgRecord& record) {
+  std::string buffer;
+  buffer.reserve(record.text.size()+160);
+
+  char number[32];
+  std::snprintf(number, sizeof(number), "%llu", record.sequence);
+  buffer += "{\"seq\":";
+  buffer += number;
+  buffer += ",\"time\":";
+  AppendTime(record.time, buffer);
+  buffer += ",\"level\":";
+  const char* name = record.name != NULL ? record.name : "";
+  AppendJsonString(name, std::strlen(name), buffer);
+  buffer += ",\"color\":\"";
+  buffer += ColorName(record.color);
+  std::snprintf(number, sizeof(number), "%d", record.indent);
+  buffer += "\",\"indent\":";
+  buffer += number;
+  std::snprintf(number, sizeof(number), "%d", record.thread);
+  buffer += ",\"thread\":";
+  buffer += number;
+  buffer += ",\"msg\":";
+  AppendJsonString(record.text.data(), record.text.size(), buffer);
+  buffer += '}';
+  return buffer;
+}
+
+void doocore::io::JsonLinesSink::Open() {
+  file_      = std::fopen(file_name_.c_str(), "w");
+  file_size_ = 0;
+  if (file_ != NULL) std::setvbuf(file_, buffer_.data(), _IOFBF, buffer_.size());
+}
+
+void doocore::io::JsonLinesSink::Rotate() {
+  std::fclose(file_);
+  file_ = NULL;
+
+  if (max_backups_ > 0) {
+    std::stringstream oldest;
+    oldest << file_name_ << "." << max_backups_;
+    std::remove(oldest.str().c_str());
+    for (int i=max_backups_-1; i>=1; --i) {
+      std::stringstream from, to;
+      from << file_name_ << "." << i;
+      to   << file_name_ << "." << i+1;
+      std::rename(from.str().c_str(), to.str().c_str());
+    }
+    std::rename(file_name_.c_str(), (file_name_+".1").c_str());
+  }
+  Open();
+}
@@ -0,0 +1,138 @@
+#ifndef DOOCORE_IO_JSONLINESSINK_H
+#define DOOCORE_IO_JSONLINESSINK_H
+
+// from STL
+#include <string>
+#include <cstdio>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+#include <boost/thread/mutex.hpp>
+
+// from here
+#include "doocore/io/MsgStream.h"
+
+// forward declarations
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::JsonLinesSink
+ * @brief MsgSink writing messages as JSON records, one per line
+ *
+ * Each message is written as one JSON object with the fields @c seq
+ * (monotonic sequence number), @c time (UTC, ISO 8601 with microseconds),
+ * @c level (name of the MsgStream, e.g. @c info or @c error), @c color,
+ * @c indent, @c thread and @c msg. Lines are written to a large file buffer
+ * without flushing per message.
+ *
+ * If the file exceeds a maximum size, it is rotated: @c log.jsonl is renamed
+ * to @c log.jsonl.1, existing backups are shifted (@c .1 to @c .2 etc.) and
+ * the oldest backup beyond the maximum number is removed.
+ *
+ * @section jls_usage Usage
+ *
+ * @code
+ * std::shared_ptr<JsonLinesSink> sink(new JsonLinesSink("job.jsonl"));
+ * MsgStream::AddSink(sink);
+ * sinfo << "Starting fit" << endmsg;
+ * // {"seq":0,"time":"2016-05-04T13:37:00.123456Z","level":"info","color":"green","indent":0,"thread":0,"msg":"Starting fit"}
+ * @endcode
+ */
+class JsonLinesSink : public MsgSink {
+ public:
+  /**
+   *  @brief Constructor for JsonLinesSink
+   *
+   *  Opens (and truncates) the file. If it cannot be opened, an exception is
+   *  thrown.
+   *
+   *  @param file_name name of the log file
+   *  @param max_file_size size in bytes after which the file is rotated (0 to never rotate)
+   *  @param max_backups number of rotated files to keep
+   */
+  JsonLinesSink(const std::string& file_name, std::size_t max_file_size=100*1024*1024, int max_backups=5);
+
+  /**
+   *  @brief Destructor for JsonLinesSink, writing all buffered messages
+   */
+  virtual ~JsonLinesSink();
+
+  /**
+   *  @brief Write a message into the file buffer
+   *
+   *  @param record message to write
+   */
+  virtual void Write(const MsgRecord& record);
+
+  /**
+   *  @brief Write the file buffer to disk
+   */
+  virtual void Flush();
+
+  /**
+   *  @brief Format a message as JSON record (without newline)
+   *
+   *  @param record message to format
+   *  @return JSON object as string
+   */
+  static std::string FormatRecord(const MsgRecord& record);
+
+ protected:
+
+ private:
+  /**
+   *  @brief Open the log file and its buffer
+   */
+  void Open();
+
+  /**
+   *  @brief Rotate the log file and reopen it
+   */
+  void Rotate();
+
+  /**
+   *  @brief Name of the log file
+   */
+  std::string file_name_;
+
+  /**
+   *  @brief Size after which the file is rotated
+   */
+  std::size_t max_file_size_;
+
+  /**
+   *  @brief Number of rotated files to keep
+   */
+  int max_backups_;
+
+  /**
+   *  @brief Log file
+   */
+  std::FILE* file_;
+
+  /**
+   *  @brief Buffer of the log file
+   */
+  std::vector<char> buffer_;
+
+  /**
+   *  @brief Bytes written to the current file
+   */
+  std::size_t file_size_;
+
+  /**
+   *  @brief Mutex for the file (Write() may be called from several threads)
+   */
+  boost::mutex mutex_;
+}; // class JsonLinesSink
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_JSONLINESSINK_H
@@ -1,14 +1,846 @@
 #include "doocore/io/MsgStream.h"
 
+// from STL
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <set>
+#include <unordered_map>
+
+// from BOOST
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ *  @brief Whether lines are prefixed with the thread number
+ */
+std::atomic<bool> thread_prefix(false);
+
+/**
+ *  @brief Get mutex for synchronous writes to MsgStream file streams
+ *
+ *  Only held while writing an already formatted line.
+ */
+boost::mutex& mutex_file_output() {
+  static boost::mutex mutex;
+  return mutex;
+}
+
+/**
+ *  @brief Append thread number prefix to a buffer if enabled
+ */
+void AppendThreadPrefix(const doocore::io::MsgRecord& record, std::string& buffer) {
+  if (!thread_prefix.load(std::memory_order_relaxed)) return;
+  char prefix[32];
+  std::snprintf(prefix, sizeof(prefix), "[thread %d] ", record.thread);
+  buffer += prefix;
+}
+
+/**
+ *  @brief Check once whether stdout is redirected
+ *
+ *  Avoids an isatty() call per message.
+ */
+bool StdoutIsRedirected() {
+  static const bool redirected = doocore::io::TerminalIsRedirected();
+  return redirected;
+}
+
+/**
+ *  @brief Append a formatted message line for the terminal to a buffer
+ */
+void FormatTerminalLine(const doocore::io::MsgRecord& record, std::string& buffer) {
+  bool colored = !StdoutIsRedirected();
+  if (colored && record.color != doocore::io::kTextNone) {
+    char color_code[32];
+    std::snprintf(color_code, sizeof(color_code), "%c[%d;%dm", 27, 1, 30+record.color);
+    buffer += color_code;
+  }
+  AppendThreadPrefix(record, buffer);
+  buffer.append(record.indent, ' ');
+  buffer += record.text;
+  if (colored) {
+    char reset_code[8];
+    std::snprintf(reset_code, sizeof(reset_code), "%c[%dm", 27, 0);
+    buffer += reset_code;
+  }
+  buffer += '\n';
+}
+
+/**
+ *  @brief Write a message to the stream's file (without flushing)
+ */
+void WriteFileLine(const doocore::io::MsgRecord& record) {
+  if (record.file == NULL) return;
+  std::string line;
+  AppendThreadPrefix(record, line);
+  line.append(record.indent, ' ');
+  line += record.text;
+  line += '\n';
+  record.file->write(line.data(), line.size());
+}
+
+/**
+ *  @brief Get the registered sinks
+ *
+ *  Never destroyed, so that messages during static destruction still work.
+ */
+std::vector<std::shared_ptr<doocore::io::MsgSink> >& sinks() {
+  static std::vector<std::shared_ptr<doocore::io::MsgSink> >* sinks = new std::vector<std::shared_ptr<doocore::io::MsgSink> >();
+  return *sinks;
+}
+
+/**
+ *  @brief Pass a message to all sinks
+ */
+void WriteSinks(const doocore::io::MsgRecord& record) {
+  std::vector<std::shared_ptr<doocore::io::MsgSink> >& all_sinks = sinks();
+  for (std::vector<std::shared_ptr<doocore::io::MsgSink> >::const_iterator it = all_sinks.begin(), end = all_sinks.end();
+       it != end; ++it) {
+    (*it)->Write(record);
+  }
+}
+
+/**
+ *  @brief Flush all sinks
+ */
+void FlushSinks() {
+  std::vector<std::shared_ptr<doocore::io::MsgSink> >& all_sinks = sinks();
+  for (std::vector<std::shared_ptr<doocore::io::MsgSink> >::const_iterator it = all_sinks.begin(), end = all_sinks.end();
+       it != end; ++it) {
+    (*it)->Flush();
+  }
+}
+
+/**
+ *  @brief Bounded lock-free multi-producer/single-consumer queue of messages
+ *
+ *  Each slot carries a sequence number telling producers and the consumer
+ *  whether it is free or filled for the current turn (Vyukov's bounded
+ *  queue). Producers claim slots with a compare-and-swap on the head, the
+ *  single consumer advances the tail without atomic read-modify-write.
+ */
+class MsgRingBuffer {
+ public:
+  explicit MsgRingBuffer(std::size_t capacity)
+  : capacity_(RoundUpPowerOfTwo(capacity)),
+    mask_(capacity_-1),
+    slots_(new Slot[capacity_]),
+    head_(0),
+    tail_(0)
+  {
+    for (std::size_t i=0; i<capacity_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   *  @brief Try to move a message into the queue
+   *
+   *  @return false if the queue is full
+   */
+  bool TryPush(doocore::io::MsgRecord& record) {
+    std::size_t position = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot&     slot     = slots_[position & mask_];
+      std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      std::ptrdiff_t diff  = static_cast<std::ptrdiff_t>(sequence)-static_cast<std::ptrdiff_t>(position);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(position, position+1, std::memory_order_relaxed)) {
+          slot.record = std::move(record);
+          slot.sequence.store(position+1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   *  @brief Try to move the oldest message out of the queue (consumer only)
+   *
+   *  @return false if the queue is empty
+   */
+  bool TryPop(doocore::io::MsgRecord& record) {
+    std::size_t position = tail_.load(std::memory_order_relaxed);
+    Slot&       slot     = slots_[position & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != position+1) return false;
+
+    record = std::move(slot.record);
+    slot.record.text.clear();
+    tail_.store(position+1, std::memory_order_relaxed);
+    slot.sequence.store(position+capacity_, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   *  @brief Check whether the oldest slot is still unfilled (consumer only)
+   */
+  bool Empty() const {
+    std::size_t position = tail_.load(std::memory_order_relaxed);
+    return slots_[position & mask_].sequence.load(std::memory_order_seq_cst) != position+1;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    doocore::io::MsgRecord   record;
+  };
+
+  static std::size_t RoundUpPowerOfTwo(std::size_t value) {
+    std::size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+  }
+
+  const std::size_t          capacity_;
+  const std::size_t          mask_;
+  std::unique_ptr<Slot[]>    slots_;
+  std::atomic<std::size_t>   head_;
+  std::atomic<std::size_t>   tail_;
+};
+
+/**
+ *  @brief Set in the background thread of AsyncMsgWriter
+ */
+thread_local bool is_writer_thread = false;
+
+/**
+ *  @brief Background thread writing messages from a MsgRingBuffer
+ *
+ *  Messages are formatted into one buffer and written with a single fwrite
+ *  per batch. Output is flushed whenever the queue runs empty, after which 
+ *  the thread sleeps until the next message arrives.
+ *
+ *  Producers register themselves while pushing, so that Stop() can wait for
+ *  all of them before the queue is drained and released. Messages emitted 
+ *  from the writer thread itself (e.g. by a sink) are not queued but have to
+ *  be written synchronously, as the writer would otherwise wait for itself.
+ */
+class AsyncMsgWriter {
+ public:
+  AsyncMsgWriter() 
+  : active_(false), stopping_(false), stop_(false), sleeping_(false), wake_(false), 
+    num_producers_(0), num_pushed_(0), num_written_(0) {}
+
+  bool active() const { return active_.load(); }
+
+  void Start(std::size_t capacity) {
+    boost::lock_guard<boost::mutex> lock_mode(mutex_mode_);
+    if (active()) return;
+    queue_.reset(new MsgRingBuffer(capacity));
+    stop_.store(false);
+    thread_.reset(new boost::thread(&AsyncMsgWriter::Run, this));
+    active_.store(true);
+  }
+
+  void Stop() {
+    boost::lock_guard<boost::mutex> lock_mode(mutex_mode_);
+    if (!active()) return;
+    stopping_.store(true);
+    active_.store(false);
+    // producers that saw the writer active finish their push first
+    while (num_producers_.load() > 0) boost::this_thread::yield();
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      stop_.store(true);
+      wake_ = true;
+    }
+    condition_wake_.notify_one();
+    thread_->join();
+    thread_.reset();
+    queue_.reset();
+    stopping_.store(false);
+    condition_written_.notify_all();
+  }
+
+  /**
+   *  @brief Queue a message if the writer is active
+   *
+   *  @return false if the message has to be written synchronously
+   */
+  bool TryPush(doocore::io::MsgRecord& record) {
+    if (is_writer_thread) return false;
+    num_producers_.fetch_add(1);
+    if (!active_.load()) {
+      num_producers_.fetch_sub(1);
+      // queued messages of this thread have to be written before its next one
+      while (stopping_.load()) boost::this_thread::yield();
+      return false;
+    }
+    num_pushed_.fetch_add(1, std::memory_order_relaxed);
+    while (!queue_->TryPush(record)) {
+      boost::this_thread::yield();
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load()) {
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        wake_ = true;
+      }
+      condition_wake_.notify_one();
+    }
+    num_producers_.fetch_sub(1);
+    return true;
+  }
+
+  void Flush() {
+    if (!active() || is_writer_thread) return;
+    unsigned long long target = num_pushed_.load();
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (num_written_.load() < target && active()) condition_written_.wait(lock);
+  }
+
+ private:
+  void Run() {
+    is_writer_thread = true;
+    doocore::io::MsgRecord record;
+    std::string            buffer;
+    std::vector<std::ostream*> files;
+    for (;;) {
+      std::size_t num_batch = 0;
+      while (num_batch < kMaxBatchSize && queue_->TryPop(record)) {
+        FormatTerminalLine(record, buffer);
+        WriteFileLine(record);
+        WriteSinks(record);
+        if (record.file != NULL) files.push_back(record.file);
+        ++num_batch;
+      }
+
+      if (num_batch > 0) {
+        std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+        buffer.clear();
+        if (num_batch < kMaxBatchSize) {
+          std::fflush(stdout);
+          for (std::vector<std::ostream*>::const_iterator it = files.begin(), end = files.end();
+               it != end; ++it) {
+            (*it)->flush();
+          }
+          files.clear();
+        }
+        {
+          boost::lock_guard<boost::mutex> lock(mutex_);
+          num_written_.fetch_add(num_batch);
+        }
+        condition_written_.notify_all();
+      } else if (stop_.load()) {
+        break;
+      } else {
+        // announce sleeping before checking the queue a last time, so that
+        // producers pushing from now on wake the thread
+        sleeping_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue_->Empty()) {
+          boost::unique_lock<boost::mutex> lock(mutex_);
+          while (!wake_) condition_wake_.wait(lock);
+        }
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        wake_ = false;
+        sleeping_.store(false);
+      }
+    }
+  }
+
+  /// maximum number of messages written per fwrite
+  static const std::size_t kMaxBatchSize = 1024;
+
+  std::unique_ptr<MsgRingBuffer>  queue_;
+  std::unique_ptr<boost::thread>  thread_;
+  std::atomic<bool>               active_;
+  std::atomic<bool>               stopping_;
+  std::atomic<bool>               stop_;
+  std::atomic<bool>               sleeping_;
+  bool                            wake_;
+  std::atomic<int>                num_producers_;
+  std::atomic<unsigned long long> num_pushed_;
+  std::atomic<unsigned long long> num_written_;
+  boost::mutex                    mutex_mode_;
+  boost::mutex                    mutex_;
+  boost::condition_variable       condition_wake_;
+  boost::condition_variable       condition_written_;
+};
+
+/**
+ *  @brief Get the writer for asynchronous output
+ *
+ *  Never destroyed, so that MsgStreams in other translation units can still
+ *  print during static destruction (synchronously after AsyncOutputShutdown).
+ */
+AsyncMsgWriter& async_writer() {
+  static AsyncMsgWriter* writer = new AsyncMsgWriter();
+  return *writer;
+}
+/**
+ *  @brief Write a message to terminal, file and sinks (or queue it)
+ */
+void Dispatch(doocore::io::MsgRecord& record) {
+  static std::atomic<unsigned long long> num_messages(0);
+  record.sequence = num_messages.fetch_add(1);
+
+  if (async_writer().TryPush(record)) return;
+
+  std::string line;
+  line.reserve(record.indent+record.text.size()+16);
+  FormatTerminalLine(record, line);
+  std::fwrite(line.data(), 1, line.size(), stdout);
+  std::fflush(stdout);
+  if (record.file != NULL) {
+    boost::lock_guard<boost::mutex> lock(mutex_file_output());
+    WriteFileLine(record);
+    record.file->flush();
+  }
+  WriteSinks(record);
+}
+
+/**
+ *  @brief Time window for deduplication in microseconds (0 if disabled)
+ */
+std::atomic<long long> deduplication_window(0);
+
+/**
+ *  @brief Suppression of identical messages within a time window
+ *
+ *  The first occurrence of a message is printed. Further identical messages
+ *  (same text, stream and indent) within the window are counted only. When 
+ *  the window has passed, a background thread prints the count as a copy of
+ *  the message with "(repeated N times)". Repeated messages are found via 
+ *  their hash, so counting them does not allocate.
+ *
+ *  Counts are taken and printed while holding the dispatch mutex, so that
+ *  Purge() guarantees no count of a stream's file is printed afterwards.
+ */
+class MsgDeduplicator {
+ public:
+  MsgDeduplicator() : window_(0), stop_(false) {}
+
+  /**
+   *  @brief Set the window, printing all pending counts
+   *
+   *  Starts the background thread for a positive window and stops it for 0.
+   */
+  void set_window(std::chrono::microseconds window) {
+    std::vector<doocore::io::MsgRecord> expired;
+    std::unique_ptr<boost::thread>      thread;
+    {
+      boost::lock_guard<boost::mutex> dispatch_lock(dispatch_mutex_);
+      {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        TakeExpired(std::chrono::system_clock::time_point::max(), expired);
+        window_ = window;
+        if (window_.count() > 0 && !thread_) {
+          stop_ = false;
+          thread_.reset(new boost::thread(&MsgDeduplicator::Run, this));
+        } else if (window_.count() <= 0 && thread_) {
+          stop_ = true;
+          thread.swap(thread_);
+        }
+      }
+      DispatchAll(expired);
+    }
+    // joined without the dispatch mutex which the thread may be waiting for
+    condition_.notify_all();
+    if (thread) thread->join();
+  }
+
+  /**
+   *  @brief Check whether to print a message
+   *
+   *  Counts expiring due to the message are printed before returning.
+   *
+   *  @param record the message
+   *  @return false if the message is a repetition within the window
+   */
+  bool Filter(const doocore::io::MsgRecord& record) {
+    std::size_t                         key = Hash(record);
+    std::vector<doocore::io::MsgRecord> expired;
+
+    boost::lock_guard<boost::mutex> dispatch_lock(dispatch_mutex_);
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      if (window_.count() <= 0) return true;
+      std::unordered_map<std::size_t, Entry>::iterator it = entries_.find(key);
+      if (it != entries_.end()) {
+        if (!Equal(it->second.record, record)) return true;
+        if (record.time < it->second.record.time+window_) {
+          ++it->second.num_repeated;
+          return false;
+        }
+      }
+
+      if (entries_.size() >= kMaxEntries) {
+        TakeExpired(std::chrono::system_clock::time_point::max(), expired);
+      } else if (it != entries_.end()) {
+        TakeExpired(record.time, expired);
+      }
+      Entry& entry       = entries_[key];
+      entry.record       = record;
+      entry.num_repeated = 0;
+    }
+    condition_.notify_all();
+    DispatchAll(expired);
+    return true;
+  }
+
+  /**
+   *  @brief Print and remove all counts of messages written to a file
+   *
+   *  Called before the file is closed, so that the background thread never
+   *  writes to it afterwards.
+   *
+   *  @param file the file stream of a MsgStream
+   */
+  void Purge(const std::ostream* file) {
+    std::vector<doocore::io::MsgRecord> purged;
+
+    boost::lock_guard<boost::mutex> dispatch_lock(dispatch_mutex_);
+    {
+      boost::lock_guard<boost::mutex> lock(mutex_);
+      for (std::unordered_map<std::size_t, Entry>::iterator it = entries_.begin(); it != entries_.end(); ) {
+        if (it->second.record.file != file) {
+          ++it;
+          continue;
+        }
+        TakeCount(it->second, purged);
+        it = entries_.erase(it);
+      }
+    }
+    DispatchAll(purged);
+  }
+
+ private:
+  struct Entry {
+    doocore::io::MsgRecord record;
+    unsigned long long     num_repeated;
+  };
+
+  static std::size_t Hash(const doocore::io::MsgRecord& record) {
+    std::size_t hash = std::hash<std::string>()(record.text);
+    hash ^= std::hash<const void*>()(record.name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<const void*>()(record.file) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= static_cast<std::size_t>(record.color*1024 + record.indent) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+  }
+
+  static bool Equal(const doocore::io::MsgRecord& a, const doocore::io::MsgRecord& b) {
+    return a.color == b.color && a.indent == b.indent && a.name == b.name && 
+           a.file == b.file && a.text == b.text;
+  }
+
+  /**
+   *  @brief Main function of the background thread printing expired counts
+   */
+  void Run() {
+    std::vector<doocore::io::MsgRecord> expired;
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (!stop_) {
+      std::chrono::system_clock::time_point next_expiry = NextExpiry();
+      if (next_expiry == std::chrono::system_clock::time_point::max()) {
+        condition_.wait(lock);
+      } else {
+        long long wait = std::chrono::duration_cast<std::chrono::microseconds>(next_expiry-std::chrono::system_clock::now()).count();
+        if (wait > 0) condition_.timed_wait(lock, boost::posix_time::microseconds(wait));
+      }
+      if (stop_ || NextExpiry() > std::chrono::system_clock::now()) continue;
+
+      // the dispatch mutex is locked first, see Purge()
+      lock.unlock();
+      {
+        boost::lock_guard<boost::mutex> dispatch_lock(dispatch_mutex_);
+        {
+          boost::lock_guard<boost::mutex> take_lock(mutex_);
+          TakeExpired(std::chrono::system_clock::now(), expired);
+        }
+        DispatchAll(expired);
+      }
+      lock.lock();
+    }
+  }
+
+  std::chrono::system_clock::time_point NextExpiry() const {
+    std::chrono::system_clock::time_point next_expiry = std::chrono::system_clock::time_point::max();
+    for (std::unordered_map<std::size_t, Entry>::const_iterator it = entries_.begin(), end = entries_.end();
+         it != end; ++it) {
+      next_expiry = std::min(next_expiry, it->second.record.time+window_);
+    }
+    return next_expiry;
+  }
+
+  /**
+   *  @brief Remove entries whose window has passed, collecting their counts
+   */
+  void TakeExpired(std::chrono::system_clock::time_point now, std::vector<doocore::io::MsgRecord>& expired) {
+    for (std::unordered_map<std::size_t, Entry>::iterator it = entries_.begin(); it != entries_.end(); ) {
+      Entry& entry = it->second;
+      if (now != std::chrono::system_clock::time_point::max() && entry.record.time+window_ > now) {
+        ++it;
+        continue;
+      }
+      TakeCount(entry, expired);
+      it = entries_.erase(it);
+    }
+  }
+
+  /**
+   *  @brief Collect the count of an entry to be removed (if repeated at all)
+   */
+  static void TakeCount(Entry& entry, std::vector<doocore::io::MsgRecord>& expired) {
+    if (entry.num_repeated > 0) {
+      std::stringstream text;
+      text << entry.record.text << " (repeated " << entry.num_repeated << " times)";
+      entry.record.text = text.str();
+      entry.record.time = std::chrono::system_clock::now();
+      expired.push_back(entry.record);
+    }
+  }
+
+  /**
+   *  @brief Print collected counts (without holding the mutex)
+   */
+  static void DispatchAll(std::vector<doocore::io::MsgRecord>& records) {
+    for (std::vector<doocore::io::MsgRecord>::iterator it = records.begin(), end = records.end();
+         it != end; ++it) {
+      Dispatch(*it);
+    }
+    records.clear();
+  }
+
+  /// maximum number of distinct messages tracked at once
+  static const std::size_t kMaxEntries = 256;
+
+  std::unordered_map<std::size_t, Entry> entries_;
+  std::chrono::microseconds              window_;
+  bool                                   stop_;
+  boost::mutex                           mutex_;
+  boost::mutex                           dispatch_mutex_;
+  boost::condition_variable              condition_;
+  std::unique_ptr<boost::thread>         thread_;
+};
+
+/**
+ *  @brief Get the deduplicator
+ *
+ *  Never destroyed, pending counts are printed by AsyncOutputShutdown.
+ */
+MsgDeduplicator& deduplicator() {
+  static MsgDeduplicator* deduplicator = new MsgDeduplicator();
+  return *deduplicator;
+}
+
+/**
+ *  @brief Registry of MsgStream identifiers and names
+ *
+ *  Never destroyed, so that streams destroyed during static destruction can
+ *  still release their identifier and queued messages keep their names.
+ */
+struct MsgStreamIds {
+  boost::mutex             mutex;
+  std::vector<std::size_t> generations;
+  std::vector<std::size_t> free_ids;
+  std::set<std::string>    names;
+};
+
+MsgStreamIds& stream_ids() {
+  static MsgStreamIds* ids = new MsgStreamIds();
+  return *ids;
+}
+
+/**
+ *  @brief Set once the calling thread's message buffers are destroyed
+ */
+thread_local bool thread_buffers_destroyed = false;
+
+/**
+ *  @brief Message buffers of one thread, indexed by MsgStream identifier
+ */
+struct ThreadBuffers {
+  struct Slot {
+    Slot() : generation(0) {}
+    std::unique_ptr<std::ostringstream> stream;
+    std::size_t                         generation;
+  };
+
+  ~ThreadBuffers() { thread_buffers_destroyed = true; }
+
+  std::vector<Slot> slots;
+};
+} // namespace
+
 namespace doocore {
 namespace io {
-int MsgStream::indent_ = 0;
-
-MsgStream serr   (kTextRed);
-MsgStream swarn  (kTextYellow);
-MsgStream sinfo  (kTextGreen);
-MsgStream scfg   (kTextBlue);
-MsgStream sout   (kTextNone);
-MsgStream sdebug (kTextNone);
+std::atomic<int> MsgStream::indent_(0);
+
+MsgStream::~MsgStream() {
+  if (filestream_.is_open()) {
+    // pending counts refer to the file stream which is closed afterwards
+    if (deduplication_window.load() > 0) deduplicator().Purge(&filestream_);
+    FlushOutput();
+  }
+  ReleaseId(id_);
+}
+
+void MsgStream::Write(MsgRecord& record) {
+  if (deduplication_window.load(std::memory_order_relaxed) > 0) {
+    if (!deduplicator().Filter(record)) return;
+  }
+  Dispatch(record);
+}
+
+void MsgStream::set_deduplication_window(double seconds) {
+  long long window = seconds > 0.0 ? static_cast<long long>(seconds*1e6) : 0;
+  deduplication_window.store(window);
+  deduplicator().set_window(std::chrono::microseconds(window));
+}
+
+MsgRateLimiter::MsgRateLimiter(double max_rate, int burst)
+: rate_(max_rate),
+  max_tokens_(static_cast<long long>(burst)*kToken),
+  tokens_(static_cast<long long>(burst)*kToken),
+  last_refill_(MicrosecondsNow()),
+  num_suppressed_(0)
+{}
+
+bool MsgRateLimiter::Allow(MsgStream& msgstream) {
+  long long now  = MicrosecondsNow();
+  long long last = last_refill_.load(std::memory_order_relaxed);
+  if (now > last && last_refill_.compare_exchange_strong(last, now)) {
+    long long refill = static_cast<long long>((now-last)*rate_);
+    long long tokens = tokens_.fetch_add(refill)+refill;
+    while (tokens > max_tokens_ && !tokens_.compare_exchange_weak(tokens, max_tokens_)) {}
+  }
+
+  if (tokens_.fetch_sub(kToken) >= kToken) {
+    unsigned long long num_suppressed = num_suppressed_.exchange(0);
+    if (num_suppressed > 0) {
+      msgstream << "(" << num_suppressed << " messages suppressed by rate limit)" << endmsg;
+    }
+    return true;
+  }
+  tokens_.fetch_add(kToken);
+  num_suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+long long MsgRateLimiter::MicrosecondsNow() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::ostringstream& MsgStream::ThreadBuffer(std::size_t id, std::size_t generation) {
+  if (thread_buffers_destroyed) {
+    // only during thread exit, intentionally leaked
+    static thread_local std::ostringstream* fallback = NULL;
+    if (fallback == NULL) fallback = new std::ostringstream();
+    return *fallback;
+  }
+
+  static thread_local ThreadBuffers buffers;
+  std::vector<ThreadBuffers::Slot>& slots = buffers.slots;
+  if (id >= slots.size()) slots.resize(id+1);
+  ThreadBuffers::Slot& slot = slots[id];
+  if (!slot.stream) {
+    slot.stream.reset(new std::ostringstream());
+  } else if (slot.generation != generation) {
+    slot.stream->str("");
+    slot.stream->clear();
+  }
+  slot.generation = generation;
+  return *slot.stream;
+}
+
+int MsgStream::ThreadNumber() {
+  static std::atomic<int> num_threads(0);
+  static thread_local int number = num_threads.fetch_add(1);
+  return number;
+}
+
+void MsgStream::AcquireId(std::size_t& id, std::size_t& generation) {
+  MsgStreamIds& ids = stream_ids();
+  boost::lock_guard<boost::mutex> lock(ids.mutex);
+  if (ids.free_ids.empty()) {
+    id = ids.generations.size();
+    ids.generations.push_back(0);
+  } else {
+    id = ids.free_ids.back();
+    ids.free_ids.pop_back();
+    ++ids.generations[id];
+  }
+  generation = ids.generations[id];
+}
+
+void MsgStream::ReleaseId(std::size_t id) {
+  MsgStreamIds& ids = stream_ids();
+  boost::lock_guard<boost::mutex> lock(ids.mutex);
+  ids.free_ids.push_back(id);
+}
+
+const char* MsgStream::InternName(const std::string& name) {
+  if (name.empty()) return NULL;
+  MsgStreamIds& ids = stream_ids();
+  boost::lock_guard<boost::mutex> lock(ids.mutex);
+  return ids.names.insert(name).first->c_str();
+}
+
+void MsgStream::set_thread_prefix(bool prefix) {
+  thread_prefix.store(prefix);
+}
+
+void MsgStream::set_asynchronous(bool asynchronous, std::size_t capacity) {
+  if (asynchronous) {
+    std::cout.flush();
+    async_writer().Start(capacity);
+  } else {
+    async_writer().Stop();
+  }
+}
+
+bool MsgStream::asynchronous() {
+  return async_writer().active();
+}
+
+void MsgStream::FlushOutput() {
+  async_writer().Flush();
+  FlushSinks();
+}
+
+void MsgStream::AddSink(std::shared_ptr<MsgSink> sink) {
+  FlushOutput();
+  sinks().push_back(sink);
+}
+
+void MsgStream::RemoveSink(const std::shared_ptr<MsgSink>& sink) {
+  FlushOutput();
+  std::vector<std::shared_ptr<MsgSink> >& all_sinks = sinks();
+  all_sinks.erase(std::remove(all_sinks.begin(), all_sinks.end(), sink), all_sinks.end());
+}
+
+MsgStream serr   (kTextRed,    "", "error");
+MsgStream swarn  (kTextYellow, "", "warning");
+MsgStream sinfo  (kTextGreen,  "", "info");
+MsgStream scfg   (kTextBlue,   "", "config");
+MsgStream sout   (kTextNone,   "", "out");
+MsgStream sdebug (kTextNone,   "", "debug");
 } // namespace utils
-} // namespace doofit
\ No newline at end of file
+} // namespace doofit
+
+namespace {
+/**
+ *  @brief Drains asynchronous output at program end
+ *
+ *  Defined after the global MsgStreams and therefore destroyed before them, 
+ *  while their file streams are still open.
+ */
+struct AsyncOutputShutdown {
+  ~AsyncOutputShutdown() { 
+    if (deduplication_window.load() > 0) deduplicator().set_window(std::chrono::microseconds(0));
+    async_writer().Stop(); 
+    FlushSinks();
+  }
+} async_output_shutdown;
+} // namespace
@@ -8,6 +8,9 @@
 #include <cstring>
 #include <vector>
 #include <set>
+#include <atomic>
+#include <memory>
+#include <chrono>
 #include <unistd.h>
 
 #include "TStopwatch.h"
@@ -50,6 +53,56 @@ enum TerminalColor {
       return false;
     }
   }
+
+/**
+ *  @brief Finished message of a MsgStream to be written by the output backend
+ */
+struct MsgRecord {
+  MsgRecord() : color(kTextNone), indent(0), file(NULL), thread(0), sequence(0), name(NULL) {}
+  /// text color of the stream
+  TerminalColor color;
+  /// indent of the message
+  int           indent;
+  /// message text (without newline)
+  std::string   text;
+  /// additional file stream of the MsgStream (NULL if none)
+  std::ostream* file;
+  /// number of the emitting thread (in order of first message)
+  int           thread;
+  /// number of the message in order of all emitted messages
+  unsigned long long sequence;
+  /// time of emission
+  std::chrono::system_clock::time_point time;
+  /// name of the emitting MsgStream (e.g. "info", NULL if none, valid until program end)
+  const char*   name;
+};
+
+/*! \class doocore::io::MsgSink
+ * \brief Interface for additional outputs of all MsgStream messages
+ *
+ * Sinks registered via MsgStream::AddSink() receive every printed message in
+ * addition to the terminal output (e.g. JsonLinesSink for log files to be 
+ * read by machines). In asynchronous mode, Write() is called from the 
+ * background writer thread only, otherwise from the printing threads, so 
+ * implementations need to be thread-safe. Messages printed by a sink from
+ * the writer thread are written synchronously, i.e. Write() is re-entered.
+ */
+class MsgSink {
+ public:
+  virtual ~MsgSink() {}
+
+  /**
+   *  \brief Write a message (may be buffered)
+   *
+   *  @param record message to write
+   */
+  virtual void Write(const MsgRecord& record) = 0;
+
+  /**
+   *  \brief Write all buffered messages
+   */
+  virtual void Flush() = 0;
+};
   
 /*! \class doocore::io::MsgStream 
  * \brief A class for message output using different messages and colors.
@@ -69,6 +122,27 @@ enum TerminalColor {
  * MsgStream mymsgstream(kTextBlue);
  * mymsgstream << "My own stream" << endmsg;
  * \endcode
+ *
+ * By default every message is written and flushed immediately. With 
+ * MsgStream::set_asynchronous(true), endmsg only moves the finished message
+ * into a lock-free ring buffer and a background thread does the coloring and
+ * writes messages in batches. Output printed directly via std::cout or printf
+ * may then appear out of order with MsgStream messages. Call 
+ * MsgStream::FlushOutput() before such output or before a program crash is 
+ * to be expected:
+ * \code
+ * MsgStream::set_asynchronous(true);
+ * for (int i=0; i<num_iterations; ++i) {
+ *   sinfo << "Iteration " << i << ": NLL = " << nll << endmsg;
+ * }
+ * MsgStream::FlushOutput();
+ * \endcode
+ *
+ * MsgStreams can be used from several threads at once. Each thread builds 
+ * its message in its own buffer, which is emitted as a whole on endmsg. 
+ * Messages of different threads therefore never interleave, without any 
+ * locking while formatting. With MsgStream::set_thread_prefix(true) each 
+ * line is prefixed with the number of the emitting thread.
  */
 class MsgStream {
 public:
@@ -76,8 +150,12 @@ public:
    *  \brief Constructor for colored output
    *
    *  @param color The color to be used for this stream
+   *  @param outfile_name name of a file to write messages to additionally
+   *  @param name name of the stream for sinks (like a log level)
    */
-  MsgStream(TerminalColor color, const std::string& outfile_name="") : text_color_(color), is_active_(true) {
+  MsgStream(TerminalColor color, const std::string& outfile_name="", const std::string& name="") 
+  : text_color_(color), is_active_(true), name_(InternName(name)) {
+    AcquireId(id_, generation_);
     if(outfile_name.length()>0){
       filestream_.open(outfile_name.c_str());
     }
@@ -86,17 +164,27 @@ public:
   /**
    *  \brief Default constructor for standard uncolored output
    */
-  MsgStream() : text_color_(kTextNone), is_active_(true) {}
+  MsgStream() : text_color_(kTextNone), is_active_(true), name_(NULL) { AcquireId(id_, generation_); }
+
+  /**
+   *  \brief Destructor, waiting for pending asynchronous output of this stream
+   *
+   *  Pending repetition counts (see set_deduplication_window()) of messages 
+   *  written to the output file are printed before the file is closed. The 
+   *  identifier of the stream is released for reuse by new streams.
+   */
+  ~MsgStream();
   
   /**
    *  \brief Get the internal std::ostringstream
    *
    *  This function returns a reference to the std::ostringstream used to store
-   *  output before it is flushed to the console.
+   *  output before it is flushed to the console. Each thread has its own 
+   *  buffer per MsgStream.
    *
-   *  \return internal std::ostringstream
+   *  \return internal std::ostringstream of the calling thread
    */
-  std::ostringstream& stream() { return os_; }
+  std::ostringstream& stream() { return ThreadBuffer(id_, generation_); }
   
   /**
    *  \brief Actually output the content of the MsgStream to std::cout. 
@@ -104,24 +192,93 @@ public:
    *  Normally not needed as endmsg() will force the output.
    *
    *  \return this MstStream object
-   *
-   *  \todo Include support for other streams as well besides std::cout.
    */
   MsgStream& doOutput() {
+    std::ostringstream& buffer = stream();
     if (is_active_) {
-      if (!TerminalIsRedirected()) SetTerminalColor(text_color_);
-      std::cout << std::string(indent_, ' ');
-      std::cout << os_.str() << std::endl;
-      if (!TerminalIsRedirected()) ResetTerminal();
-      if (filestream_.is_open()){
-        filestream_ << std::string(indent_, ' ');
-        filestream_ << os_.str() << std::endl;
-      }
+      MsgRecord record;
+      record.color  = text_color_;
+      record.indent = indent_;
+      record.text   = buffer.str();
+      record.file   = filestream_.is_open() ? &filestream_ : NULL;
+      record.thread = ThreadNumber();
+      record.time   = std::chrono::system_clock::now();
+      record.name   = name_;
+      Write(record);
     }
-    os_.str("");
+    buffer.str("");
       
     return *this;
   }
+
+  /**
+   *  \brief Enable or disable asynchronous output for all MsgStreams
+   *
+   *  In asynchronous mode, messages are passed via a lock-free ring buffer 
+   *  with @a capacity slots (rounded up to a power of two) to a background 
+   *  thread writing them. If the buffer is full, endmsg waits for free slots,
+   *  so no messages are lost. Disabling writes all pending messages first.
+   *  Modes can be switched while other threads are printing, messages of 
+   *  each thread keep their order. The background
+   *  thread sleeps while no messages are pending.
+   *
+   *  @param asynchronous whether to write asynchronously
+   *  @param capacity number of messages in the ring buffer
+   */
+  static void set_asynchronous(bool asynchronous, std::size_t capacity=8192);
+
+  /**
+   *  \brief Check whether output is asynchronous
+   *
+   *  @return true if messages are written by a background thread
+   */
+  static bool asynchronous();
+
+  /**
+   *  \brief Wait until all pending messages are written and flushed
+   *
+   *  Also flushes all sinks.
+   */
+  static void FlushOutput();
+
+  /**
+   *  \brief Enable or disable thread number prefixes for all MsgStreams
+   *
+   *  If enabled, each line is prefixed with @c [thread N], where threads are 
+   *  numbered in order of their first message starting with 0.
+   *
+   *  @param thread_prefix whether to prefix lines with the thread number
+   */
+  static void set_thread_prefix(bool thread_prefix);
+
+  /**
+   *  \brief Set time window to collapse repeated messages in
+   *
+   *  If enabled, identical messages (same stream, indent and text) printed 
+   *  within @a seconds after the first one are suppressed. After the window,
+   *  their number is printed by a background thread as copy of the message 
+   *  with @c "(repeated N times)". Disabled (0) by default.
+   *
+   *  @param seconds length of the window (0 to disable)
+   */
+  static void set_deduplication_window(double seconds);
+
+  /**
+   *  \brief Add a sink receiving all messages of all MsgStreams
+   *
+   *  Add sinks only while no other threads are printing. Buffered messages of
+   *  sinks are written by FlushOutput() and at program end.
+   *
+   *  @param sink the sink to add
+   */
+  static void AddSink(std::shared_ptr<MsgSink> sink);
+
+  /**
+   *  \brief Remove a sink added via AddSink() after flushing it
+   *
+   *  @param sink the sink to remove
+   */
+  static void RemoveSink(const std::shared_ptr<MsgSink>& sink);
   
   /**
    *  \brief Stream operator for std::ostream streams. 
@@ -130,7 +287,7 @@ public:
    *  iostreams documentation for reference.
    */
   MsgStream& operator<<(std::ostream& (*_f)(std::ostream&)) {
-    _f(os_);
+    _f(stream());
     return *this;
   }
   
@@ -150,7 +307,7 @@ public:
    */
   void Ruler() {
     for (int i=indent_; i<120; ++i) {
-      os_ << "=";
+      stream() << "=";
     }
     doOutput();
   }
@@ -164,6 +321,13 @@ public:
    *  @param active_state determines whether printing is enabled or disabled
    */
   void set_active(bool active_state) { is_active_ = active_state; }
+
+  /**
+   *  \brief Get active state of this stream
+   *
+   *  @return whether messages sent to this stream are printed
+   */
+  bool is_active() const { return is_active_; }
   
   /**
    *  \brief Set current indent for new lines
@@ -212,20 +376,82 @@ protected:
   /**
    *  \brief Flush the internal std::ostringstream and output.
    */
-  void flush() { os_.flush(); doOutput(); }
+  void flush() { stream().flush(); doOutput(); }
+
+  /**
+   *  @brief Pass a finished message to the output backend
+   *
+   *  @param record message to write (its text may be moved from)
+   */
+  static void Write(MsgRecord& record);
+
+  /**
+   *  @brief Get the calling thread's message buffer of a MsgStream
+   *
+   *  A buffer left over from a former stream with the same identifier is 
+   *  cleared. After the calling thread's buffers have been destroyed (i.e. 
+   *  during its exit or static destruction), all streams share one buffer 
+   *  per thread.
+   *
+   *  @param id identifier of the MsgStream
+   *  @param generation generation of the identifier
+   */
+  static std::ostringstream& ThreadBuffer(std::size_t id, std::size_t generation);
+
+  /**
+   *  @brief Get the number of the calling thread
+   */
+  static int ThreadNumber();
+
+  /**
+   *  @brief Get an unused MsgStream identifier
+   *
+   *  Identifiers of destroyed streams are reused with increased generation, 
+   *  so that per-thread buffers do not grow with the number of streams ever
+   *  created.
+   *
+   *  @param id the identifier
+   *  @param generation the generation of the identifier
+   */
+  static void AcquireId(std::size_t& id, std::size_t& generation);
+
+  /**
+   *  @brief Release a MsgStream identifier for reuse
+   *
+   *  @param id the identifier
+   */
+  static void ReleaseId(std::size_t id);
+
+  /**
+   *  @brief Get a copy of a stream name that is never freed
+   *
+   *  Queued messages refer to the name of their stream, which may be 
+   *  destroyed before they are written. Equal names share one copy.
+   *
+   *  @param name the name
+   *  @return the copy (NULL for an empty name)
+   */
+  static const char* InternName(const std::string& name);
   
-  /// \brief Internal std::ostringstream for data.
-  std::ostringstream os_;            
   /// \brief Text color for output.
   TerminalColor text_color_;
   
   /// \brief determining if stream is active or not (i.e. printing)
   bool is_active_;
+
+  /// \brief Identifier of this stream to find per-thread buffers.
+  std::size_t id_;
+
+  /// \brief Generation of the identifier (increased on each reuse).
+  std::size_t generation_;
+
+  /// \brief Name of this stream for sinks (see InternName()).
+  const char* name_;
   
   /**
    *  \brief Indent for new lines.
    */
-  static int indent_;
+  static std::atomic<int> indent_;
 
   /**
    *  \brief Stream for file output.
@@ -233,6 +459,50 @@ protected:
   std::ofstream filestream_;
 };
 
+/*! \class doocore::io::MsgRateLimiter
+ * \brief Token bucket limiting the rate of messages from one call site
+ *
+ * Normally used via DOOCORE_RATE_LIMITED(). Allows bursts of up to @a burst
+ * messages and @a max_rate messages per second on average. The limiter is
+ * lock-free and checked before the message is formatted. The number of 
+ * suppressed messages is printed before the next allowed one.
+ */
+class MsgRateLimiter {
+ public:
+  /**
+   *  \brief Constructor for MsgRateLimiter
+   *
+   *  @param max_rate average number of messages per second
+   *  @param burst maximum number of messages at once
+   */
+  MsgRateLimiter(double max_rate, int burst);
+
+  /**
+   *  \brief Take a token for a message
+   *
+   *  @param msgstream stream to report suppressed messages to
+   *  @return true if the message may be printed
+   */
+  bool Allow(MsgStream& msgstream);
+
+ private:
+  /// microtokens per token
+  static const long long kToken = 1000000;
+
+  static long long MicrosecondsNow();
+
+  /// refill rate in microtokens per microsecond (i.e. tokens per second)
+  const double rate_;
+  /// bucket size in microtokens
+  const long long max_tokens_;
+  /// available microtokens
+  std::atomic<long long> tokens_;
+  /// time of last refill in microseconds
+  std::atomic<long long> last_refill_;
+  /// messages suppressed since the last allowed one
+  std::atomic<unsigned long long> num_suppressed_;
+};
+
 /// \brief MsgStream function to end a message (i.e. newline) and force the output. 
 ///
 /// Not to be called directly but to be used together with 
@@ -449,4 +719,66 @@ extern MsgStream sdebug;
 } // namespace io
 } // namespace coocore
 
+/** @name Log levels
+ *  Levels of the predefined MsgStreams for DOOCORE_MIN_LOG_LEVEL.
+ */
+///@{
+#define DOOCORE_LOG_LEVEL_DEBUG   0
+#define DOOCORE_LOG_LEVEL_CONFIG  1
+#define DOOCORE_LOG_LEVEL_INFO    2
+#define DOOCORE_LOG_LEVEL_WARNING 3
+#define DOOCORE_LOG_LEVEL_ERROR   4
+///@}
+
+/**
+ *  @brief Minimum log level compiled in
+ *
+ *  Messages via the DOOCORE_* log macros below this level are removed at 
+ *  compile time. Release builds of DooCore define it to 
+ *  DOOCORE_LOG_LEVEL_CONFIG, i.e. without debug messages.
+ */
+#ifndef DOOCORE_MIN_LOG_LEVEL
+#define DOOCORE_MIN_LOG_LEVEL DOOCORE_LOG_LEVEL_DEBUG
+#endif
+
+/**
+ *  @brief Stream to a MsgStream only if its level is compiled in and it is active
+ *
+ *  Unlike streaming to a MsgStream directly, the streamed expressions are not
+ *  evaluated at all if the message is not printed. This allows debug 
+ *  messages in hot loops at no cost:
+ *  @code
+ *  DOOCORE_DEBUG << "pull = " << (y-c)/e << endmsg;
+ *  @endcode
+ *  The macros expand to an if/else statement and can be used wherever a 
+ *  single statement is allowed.
+ */
+#define DOOCORE_LOG(level, msgstream) \
+  if ((level) < DOOCORE_MIN_LOG_LEVEL || !(msgstream).is_active()) {} else (msgstream)
+
+#define DOOCORE_DEBUG   DOOCORE_LOG(DOOCORE_LOG_LEVEL_DEBUG,   doocore::io::sdebug)
+#define DOOCORE_CONFIG  DOOCORE_LOG(DOOCORE_LOG_LEVEL_CONFIG,  doocore::io::scfg)
+#define DOOCORE_INFO    DOOCORE_LOG(DOOCORE_LOG_LEVEL_INFO,    doocore::io::sinfo)
+#define DOOCORE_WARNING DOOCORE_LOG(DOOCORE_LOG_LEVEL_WARNING, doocore::io::swarn)
+#define DOOCORE_ERROR   DOOCORE_LOG(DOOCORE_LOG_LEVEL_ERROR,   doocore::io::serr)
+
+/**
+ *  @brief Stream to a MsgStream with a per-call-site rate limit
+ *
+ *  Each use of the macro has its own MsgRateLimiter allowing bursts of 
+ *  @a burst messages and @a max_rate messages per second on average 
+ *  (both have to be constants). Suppressed messages are neither formatted 
+ *  nor printed, their number is reported before the next allowed message:
+ *  @code
+ *  for (int i=0; i<num_toys; ++i) {
+ *    DOOCORE_RATE_LIMITED(swarn, 1.0, 10) << "Fit of toy " << i << " did not converge." << endmsg;
+ *  }
+ *  @endcode
+ */
+#define DOOCORE_RATE_LIMITED(msgstream, max_rate, burst) \
+  if (!(msgstream).is_active() || \
+      ![]() -> doocore::io::MsgRateLimiter& { \
+        static doocore::io::MsgRateLimiter limiter((max_rate), (burst)); return limiter; \
+      }().Allow(msgstream)) {} else (msgstream)
+
 #endif // DOOCORE_IO_MSGSTREAM_H
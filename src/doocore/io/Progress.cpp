@@ -4,6 +4,7 @@
 #include <string>
 #include <chrono>
 #include <cmath>
+#include <cstdio>
 
 // POSIX/UNIX
 #include <unistd.h>
@@ -23,7 +24,8 @@ progress_fraction_(0.0),
 tty_(isatty(fileno(stdout))),
 time_start_(std::chrono::high_resolution_clock::now()),
 time_now_(std::chrono::high_resolution_clock::now()),
-elapsed_(0)
+elapsed_(0),
+bytes_processed_(0)
 {
   if (name_task.size() > 0) {
     sinfo << "Progress: " << name_task_ << endmsg;
@@ -35,6 +37,15 @@ std::string doocore::io::Progress::SecondsToTimeString(double seconds) const {
   return doocore::io::tools::SecondsToTimeString(seconds);
 }
 
+std::string doocore::io::Progress::MakeRateString() const {
+  long long bytes = bytes_processed_;
+  if (bytes <= 0 || elapsed_ <= 0.0) return "";
+
+  char rate[32];
+  snprintf(rate, sizeof(rate), " [%.1f MB/s]", bytes/elapsed_/(1024.0*1024.0));
+  return rate;
+}
+
 std::string doocore::io::Progress::MakeProgressBar(double fraction) const {
   static unsigned int cols = 42;
   unsigned int cols_filled = round(fraction*(cols-2));
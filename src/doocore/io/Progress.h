@@ -4,6 +4,7 @@
 // from STL
 #include <string>
 #include <chrono>
+#include <atomic>
 
 // from DooCore
 #include "doocore/io/MsgStream.h"
@@ -26,6 +27,10 @@ namespace io {
  * 
  *  -O0: ~60 ns.
  *  -O3: ~4 ns.
+ *
+ *  For I/O tasks, the number of bytes processed so far can be reported via 
+ *  set_bytes_processed() (also from other threads). The indicator then 
+ *  additionally prints the throughput in MB/s.
  *  
  *  @section p_example Usage example
  *
@@ -79,6 +84,15 @@ class Progress {
     return *this;
   }
   
+  /**
+   *  @brief Set number of bytes processed so far (thread-safe)
+   *
+   *  @param bytes number of bytes processed since start of the task
+   */
+  void set_bytes_processed(long long bytes) {
+    bytes_processed_ = bytes;
+  }
+  
   /**
    *  @brief Finish progress writing by printing the progress permanently
    */
@@ -105,7 +119,7 @@ class Progress {
       time_now_ = std::chrono::high_resolution_clock::now();
       elapsed_ = std::chrono::duration_cast<std::chrono::microseconds>(time_now_ - time_start_).count()*1e-6;
       double remaining = static_cast<double>(elapsed_)/progress_fraction_-static_cast<double>(elapsed_);
-      printf("%s %.2f %% (el. / rem. / it.[ms]: %s / %s / %.2f)        \xd", MakeProgressBar(progress_fraction_).c_str(), (progress_fraction_*100.0), SecondsToTimeString(elapsed_).c_str(), SecondsToTimeString(remaining).c_str(), (elapsed_/position_*1000.0));
+      printf("%s %.2f %% (el. / rem. / it.[ms]: %s / %s / %.2f)%s        \xd", MakeProgressBar(progress_fraction_).c_str(), (progress_fraction_*100.0), SecondsToTimeString(elapsed_).c_str(), SecondsToTimeString(remaining).c_str(), (elapsed_/position_*1000.0), MakeRateString().c_str());
       fflush(stdout);
     } else if ((!tty_ && steps_since_update_ > step_position_update_notty_) || force_update){
       position_ += steps_since_update_;
@@ -119,7 +133,7 @@ class Progress {
       time_now_ = std::chrono::high_resolution_clock::now();
       elapsed_ = std::chrono::duration_cast<std::chrono::microseconds>(time_now_ - time_start_).count()*1e-6;
       double remaining = static_cast<double>(elapsed_)/progress_fraction_-static_cast<double>(elapsed_);
-      printf("%s %.2f %% (el. / rem. / it.[ms]: %s / %s / %.2f)        \n", MakeProgressBar(progress_fraction_).c_str(), progress_fraction_*100.0, SecondsToTimeString(elapsed_).c_str(), SecondsToTimeString(remaining).c_str(), elapsed_/position_*1000.0);
+      printf("%s %.2f %% (el. / rem. / it.[ms]: %s / %s / %.2f)%s        \n", MakeProgressBar(progress_fraction_).c_str(), progress_fraction_*100.0, SecondsToTimeString(elapsed_).c_str(), SecondsToTimeString(remaining).c_str(), elapsed_/position_*1000.0, MakeRateString().c_str());
       fflush(stdout);
     }
   }
@@ -128,6 +142,8 @@ class Progress {
   
   std::string MakeProgressBar(double fraction) const;
   
+  std::string MakeRateString() const;
+  
   /**
    *  @brief Name of the task to perform
    */
@@ -182,6 +198,11 @@ class Progress {
    *  @brief Elapsed time
    */
   double elapsed_;
+  
+  /**
+   *  @brief Bytes processed (0 if not reported)
+   */
+  std::atomic<long long> bytes_processed_;
 };
 
 } // namespace io
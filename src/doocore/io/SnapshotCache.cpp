@@ -0,0 +1,336 @@
+#include "doocore/io/SnapshotCache.h"
+
+// from STL
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <iomanip>
+#include <memory>
+
+// POSIX/UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// from ROOT
+
+// from RooFit
+#include "RooArgSet.h"
+#include "RooAbsArg.h"
+#include "RooDataSet.h"
+#include "RooRealVar.h"
+#include "RooCategory.h"
+
+// from BOOST
+#include <boost/filesystem.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+#include "doocore/io/Tools.h"
+
+namespace {
+/// magic string and version at the beginning of each snapshot file
+const char kSnapshotMagic[8] = {'D','C','S','N','A','P','0','1'};
+
+/// column types in snapshot file
+enum SnapshotColumnType {
+  kSnapshotReal     = 0,
+  kSnapshotCategory = 1
+};
+
+/**
+ *  @brief Bounds-checked sequential reader on a memory-mapped snapshot
+ */
+class MappedReader {
+ public:
+  MappedReader(const char* begin, const char* end) : begin_(begin), pos_(begin), end_(end) {}
+
+  bool Read(void* target, std::size_t size) {
+    if (static_cast<std::size_t>(end_-pos_) < size) return false;
+    std::memcpy(target, pos_, size);
+    pos_ += size;
+    return true;
+  }
+
+  bool ReadString(std::string& target) {
+    unsigned long long length = 0;
+    if (!Read(&length, sizeof(length))) return false;
+    if (static_cast<unsigned long long>(end_-pos_) < length) return false;
+    target.assign(pos_, length);
+    pos_ += length;
+    return true;
+  }
+
+  /// skip to next 8 byte boundary relative to file start
+  void Align() {
+    std::size_t offset = pos_-begin_;
+    pos_ = begin_ + ((offset+7)/8)*8;
+    if (pos_ > end_) pos_ = end_;
+  }
+
+  const char* Take(std::size_t size) {
+    if (static_cast<std::size_t>(end_-pos_) < size) return NULL;
+    const char* data = pos_;
+    pos_ += size;
+    return data;
+  }
+
+ private:
+  const char* begin_;
+  const char* pos_;
+  const char* end_;
+};
+
+void WriteString(std::ofstream& stream, const std::string& str) {
+  unsigned long long length = str.length();
+  stream.write(reinterpret_cast<const char*>(&length), sizeof(length));
+  stream.write(str.data(), length);
+}
+
+void WritePadding(std::ofstream& stream) {
+  static const char zeros[8] = {0,0,0,0,0,0,0,0};
+  std::streamoff offset = stream.tellp();
+  if (offset%8 != 0) stream.write(zeros, 8-offset%8);
+}
+
+/**
+ *  @brief Description of one column in a snapshot file
+ */
+struct SnapshotColumn {
+  unsigned int type;
+  std::string  name;
+  std::string  title;
+  double       min;
+  double       max;
+  const char*  data;
+};
+} // namespace
+
+doocore::io::SnapshotCache::SnapshotCache(const std::string& cache_directory)
+: cache_directory_(cache_directory)
+{}
+
+std::string doocore::io::SnapshotCache::FileName(const std::string& key) const {
+  std::stringstream file_name;
+  file_name << std::hex << std::setw(16) << std::setfill('0') << doocore::io::tools::HashString(key) << ".dcsnap";
+  return (boost::filesystem::path(cache_directory_) / file_name.str()).string();
+}
+
+RooDataSet* doocore::io::SnapshotCache::Load(const std::string& key, const RooArgSet& variables) const {
+  std::string file_name = FileName(key);
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(fd);
+    return NULL;
+  }
+  std::size_t size = file_stat.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    swarn << "SnapshotCache::Load(...): Cannot map snapshot " << file_name << " into memory. Ignoring snapshot." << endmsg;
+    return NULL;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  const char* begin = static_cast<const char*>(map);
+  MappedReader reader(begin, begin+size);
+
+  char magic[8];
+  std::string stored_key;
+  unsigned long long num_entries = 0, num_columns = 0;
+  bool valid = reader.Read(magic, sizeof(magic)) &&
+               std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0 &&
+               reader.ReadString(stored_key) && stored_key == key &&
+               reader.Read(&num_entries, sizeof(num_entries)) &&
+               reader.Read(&num_columns, sizeof(num_columns));
+
+  std::vector<SnapshotColumn> columns;
+  for (unsigned long long i=0; valid && i<num_columns; ++i) {
+    SnapshotColumn column;
+    valid = reader.Read(&column.type, sizeof(column.type)) &&
+            reader.ReadString(column.name) &&
+            reader.ReadString(column.title) &&
+            reader.Read(&column.min, sizeof(column.min)) &&
+            reader.Read(&column.max, sizeof(column.max));
+    columns.push_back(column);
+  }
+  for (std::vector<SnapshotColumn>::iterator it = columns.begin(), end = columns.end();
+       valid && it != end; ++it) {
+    reader.Align();
+    std::size_t size_value = it->type == kSnapshotReal ? sizeof(double) : sizeof(int);
+    it->data = reader.Take(size_value*num_entries);
+    valid = it->data != NULL;
+  }
+
+  if (!valid) {
+    swarn << "SnapshotCache::Load(...): Snapshot " << file_name << " is invalid or does not match the requested key. Ignoring snapshot." << endmsg;
+    munmap(map, size);
+    return NULL;
+  }
+
+  // collect variables for all columns, creating variables for columns not
+  // supplied by the caller (like formula columns added after conversion)
+  RooArgSet columns_set;
+  std::vector<std::unique_ptr<RooRealVar> > created_vars;
+  for (std::vector<SnapshotColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    RooAbsArg* arg = variables.find(it->name.c_str());
+    if (it->type == kSnapshotReal && dynamic_cast<RooRealVar*>(arg) == NULL) {
+      created_vars.push_back(std::unique_ptr<RooRealVar>(new RooRealVar(it->name.c_str(), it->title.c_str(), it->min, it->max)));
+      arg = created_vars.back().get();
+    } else if (it->type == kSnapshotCategory && dynamic_cast<RooCategory*>(arg) == NULL) {
+      swarn << "SnapshotCache::Load(...): Category " << it->name << " not supplied. Ignoring snapshot " << file_name << "." << endmsg;
+      munmap(map, size);
+      return NULL;
+    }
+    columns_set.add(*arg);
+  }
+
+  RooDataSet* dataset = new RooDataSet("dataset", "dataset", columns_set);
+  const RooArgSet* row = dataset->get();
+
+  std::vector<RooRealVar*>  row_reals;
+  std::vector<const double*> data_reals;
+  std::vector<RooCategory*> row_cats;
+  std::vector<const int*>    data_cats;
+  for (std::vector<SnapshotColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    if (it->type == kSnapshotReal) {
+      row_reals.push_back(dynamic_cast<RooRealVar*>(row->find(it->name.c_str())));
+      data_reals.push_back(reinterpret_cast<const double*>(it->data));
+    } else {
+      row_cats.push_back(dynamic_cast<RooCategory*>(row->find(it->name.c_str())));
+      data_cats.push_back(reinterpret_cast<const int*>(it->data));
+    }
+  }
+
+  for (unsigned long long i=0; i<num_entries; ++i) {
+    for (std::size_t j=0; j<row_reals.size(); ++j) {
+      row_reals[j]->setVal(data_reals[j][i]);
+    }
+    for (std::size_t j=0; j<row_cats.size(); ++j) {
+      row_cats[j]->setIndex(data_cats[j][i]);
+    }
+    dataset->add(*row);
+  }
+
+  munmap(map, size);
+  return dataset;
+}
+
+bool doocore::io::SnapshotCache::Save(const std::string& key, const RooDataSet& dataset) const {
+  namespace fs = boost::filesystem;
+
+  if (dataset.isWeighted()) {
+    swarn << "SnapshotCache::Save(...): Weighted datasets are not supported. Snapshot will not be stored." << endmsg;
+    return false;
+  }
+
+  const RooArgSet* row = dataset.get();
+  std::vector<SnapshotColumn>  columns;
+  std::vector<const RooRealVar*>     row_reals;
+  std::vector<const RooAbsCategory*> row_cats;
+
+  TIterator* it  = row->createIterator();
+  RooAbsArg* arg = NULL;
+  while ((arg = dynamic_cast<RooAbsArg*>(it->Next()))) {
+    RooRealVar*     var = dynamic_cast<RooRealVar*>(arg);
+    RooAbsCategory* cat = dynamic_cast<RooAbsCategory*>(arg);
+    SnapshotColumn column;
+    column.name  = arg->GetName();
+    column.title = arg->GetTitle();
+    column.min   = 0.0;
+    column.max   = 0.0;
+    column.data  = NULL;
+    if (var != NULL) {
+      column.type = kSnapshotReal;
+      column.min  = var->getMin();
+      column.max  = var->getMax();
+      row_reals.push_back(var);
+    } else if (cat != NULL) {
+      column.type = kSnapshotCategory;
+      row_cats.push_back(cat);
+    } else {
+      swarn << "SnapshotCache::Save(...): Column " << arg->GetName() << " is neither RooRealVar nor category. Snapshot will not be stored." << endmsg;
+      delete it;
+      return false;
+    }
+    columns.push_back(column);
+  }
+  delete it;
+
+  // the row set is updated in place by RooDataSet::get(i), so values can be
+  // read through the pointers resolved above
+  unsigned long long num_entries = dataset.numEntries();
+  std::vector<std::vector<double> > values_reals(row_reals.size(), std::vector<double>(num_entries));
+  std::vector<std::vector<int> >    values_cats(row_cats.size(), std::vector<int>(num_entries));
+  for (unsigned long long i=0; i<num_entries; ++i) {
+    dataset.get(i);
+    for (std::size_t j=0; j<row_reals.size(); ++j) {
+      values_reals[j][i] = row_reals[j]->getVal();
+    }
+    for (std::size_t j=0; j<row_cats.size(); ++j) {
+      values_cats[j][i] = row_cats[j]->getIndex();
+    }
+  }
+
+  try {
+    if (!fs::exists(cache_directory_)) fs::create_directories(cache_directory_);
+  } catch (const fs::filesystem_error& e) {
+    swarn << "SnapshotCache::Save(...): Cannot create cache directory " << cache_directory_ << ": " << e.what() << endmsg;
+    return false;
+  }
+
+  std::string file_name = FileName(key);
+  std::stringstream temp_name;
+  temp_name << file_name << ".tmp" << getpid();
+
+  std::ofstream stream(temp_name.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!stream.is_open()) {
+    swarn << "SnapshotCache::Save(...): Cannot write snapshot " << temp_name.str() << "." << endmsg;
+    return false;
+  }
+
+  unsigned long long num_columns = columns.size();
+  stream.write(kSnapshotMagic, sizeof(kSnapshotMagic));
+  WriteString(stream, key);
+  stream.write(reinterpret_cast<const char*>(&num_entries), sizeof(num_entries));
+  stream.write(reinterpret_cast<const char*>(&num_columns), sizeof(num_columns));
+  for (std::vector<SnapshotColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    stream.write(reinterpret_cast<const char*>(&it->type), sizeof(it->type));
+    WriteString(stream, it->name);
+    WriteString(stream, it->title);
+    stream.write(reinterpret_cast<const char*>(&it->min), sizeof(it->min));
+    stream.write(reinterpret_cast<const char*>(&it->max), sizeof(it->max));
+  }
+
+  std::size_t index_real = 0, index_cat = 0;
+  for (std::vector<SnapshotColumn>::const_iterator it = columns.begin(), end = columns.end();
+       it != end; ++it) {
+    WritePadding(stream);
+    if (it->type == kSnapshotReal) {
+      stream.write(reinterpret_cast<const char*>(values_reals[index_real++].data()), sizeof(double)*num_entries);
+    } else {
+      stream.write(reinterpret_cast<const char*>(values_cats[index_cat++].data()), sizeof(int)*num_entries);
+    }
+  }
+  stream.close();
+
+  if (stream.fail() || std::rename(temp_name.str().c_str(), file_name.c_str()) != 0) {
+    swarn << "SnapshotCache::Save(...): Writing snapshot " << file_name << " failed." << endmsg;
+    std::remove(temp_name.str().c_str());
+    return false;
+  }
+
+  sinfo << "SnapshotCache::Save(...): Stored " << num_entries << " entries in snapshot " << file_name << endmsg;
+  return true;
+}
@@ -0,0 +1,117 @@
+#ifndef DOOCORE_IO_SNAPSHOTCACHE_H
+#define DOOCORE_IO_SNAPSHOTCACHE_H
+
+// from STL
+#include <string>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class RooArgSet;
+class RooDataSet;
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::SnapshotCache
+ * @brief On-disk columnar cache for converted RooDataSets
+ *
+ * SnapshotCache stores the result of a tuple conversion as a flat column file
+ * inside a cache directory. Each snapshot is identified by a key string that
+ * has to describe everything the conversion depends on (source files and
+ * modification times, variables, cuts, ...). The file name is derived from a
+ * hash of the key, the full key is stored in the file and checked on loading
+ * to exclude hash collisions.
+ *
+ * Loading a snapshot maps the file into memory via mmap and fills the
+ * RooDataSet directly from the columns without touching the original TTree.
+ *
+ * The file layout is native-endian and not meant to be shared between
+ * machines of different architectures:
+ *
+ *  - 8 byte magic string and version
+ *  - key, number of entries and number of columns
+ *  - per column: type (real/category), name, title and range
+ *  - column data, 8 byte aligned: doubles for reals, 32 bit integers for
+ *    category indices
+ *
+ * Weighted datasets are not supported and will not be stored.
+ *
+ * @section sc_usage Usage
+ *
+ * SnapshotCache is normally used through
+ * doocore::io::EasyTuple::set_cache_directory(), but can be used standalone:
+ *
+ * @code
+ * SnapshotCache cache("/tmp/dataset_cache");
+ * RooDataSet* data = cache.Load(key, variables);
+ * if (data == NULL) {
+ *   data = ...; // expensive conversion
+ *   cache.Save(key, *data);
+ * }
+ * @endcode
+ */
+class SnapshotCache {
+ public:
+  /**
+   *  @brief Constructor for SnapshotCache
+   *
+   *  The cache directory will be created on first use if not existing.
+   *
+   *  @param cache_directory directory to store snapshot files in
+   */
+  SnapshotCache(const std::string& cache_directory);
+
+  /**
+   *  @brief Load snapshot for a given key
+   *
+   *  Variables in @a variables are used as templates for the dataset columns
+   *  with the same name. Columns not found in @a variables (e.g. previously
+   *  added formula columns) are created as RooRealVar with the stored range.
+   *
+   *  @param key key string identifying the snapshot
+   *  @param variables variables to use for the dataset columns
+   *  @return new RooDataSet (ownership passed to caller) or NULL if no valid snapshot exists
+   */
+  RooDataSet* Load(const std::string& key, const RooArgSet& variables) const;
+
+  /**
+   *  @brief Save snapshot of a dataset for a given key
+   *
+   *  The snapshot is written to a temporary file first and moved into place
+   *  afterwards so that concurrent jobs will never read incomplete snapshots.
+   *
+   *  @param key key string identifying the snapshot
+   *  @param dataset dataset to store
+   *  @return whether the snapshot could be stored
+   */
+  bool Save(const std::string& key, const RooDataSet& dataset) const;
+
+  /**
+   *  @brief Get file name of snapshot for a given key
+   *
+   *  @param key key string identifying the snapshot
+   *  @return file name of snapshot in cache directory
+   */
+  std::string FileName(const std::string& key) const;
+
+ protected:
+
+ private:
+  /**
+   *  @brief Directory for snapshot files
+   */
+  std::string cache_directory_;
+}; // class SnapshotCache
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_SNAPSHOTCACHE_H
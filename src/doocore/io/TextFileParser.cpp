@@ -0,0 +1,232 @@
+#include "doocore/io/TextFileParser.h"
+
+// from STL
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+// from POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// from BOOST
+#include <boost/thread.hpp>
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+namespace {
+/**
+ *  @brief Check whether a character separates fields
+ */
+inline bool IsSeparator(char c) {
+  return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+}
+
+/**
+ *  @brief Get end of the line starting at @a first (position of newline or @a last)
+ */
+inline const char* LineEnd(const char* first, const char* last) {
+  const char* end = static_cast<const char*>(std::memchr(first, '\n', last-first));
+  return end != NULL ? end : last;
+}
+
+/**
+ *  @brief Get first non-separator character of a line
+ */
+inline const char* SkipSeparators(const char* first, const char* last) {
+  while (first < last && IsSeparator(*first)) ++first;
+  return first;
+}
+
+/**
+ *  @brief Check whether a line is empty or a comment
+ */
+inline bool IsIgnoredLine(const char* first, const char* last) {
+  first = SkipSeparators(first, last);
+  return first == last || *first == '#';
+}
+
+/**
+ *  @brief Parse one line into values
+ *
+ *  The line must be followed by a character not belonging to a number (i.e.
+ *  newline or terminating null), as @c strtod has no length limit.
+ *
+ *  @return true if exactly values.size() numbers were found
+ */
+bool ParseLine(const char* first, const char* last, std::vector<double>& values) {
+  const char* pos = first;
+  for (std::size_t i=0; i<values.size(); ++i) {
+    pos = SkipSeparators(pos, last);
+    if (pos == last) return false;
+    char* next = NULL;
+    values[i] = std::strtod(pos, &next);
+    if (next == pos || next > last) return false;
+    pos = next;
+  }
+  return SkipSeparators(pos, last) == last;
+}
+} // namespace
+
+doocore::io::TextFileParser::TextFileParser(const std::string& file_name)
+: file_name_(file_name),
+  file_descriptor_(-1),
+  data_(NULL),
+  size_(0),
+  data_offset_(0),
+  num_bad_lines_(0)
+{
+  file_descriptor_ = open(file_name.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if (file_descriptor_ < 0 || fstat(file_descriptor_, &file_stat) != 0) {
+    serr << "TextFileParser: Cannot open file " << file_name << "." << endmsg;
+    if (file_descriptor_ >= 0) close(file_descriptor_);
+    throw 1;
+  }
+
+  size_ = file_stat.st_size;
+  if (size_ > 0) {
+    void* data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, file_descriptor_, 0);
+    if (data == MAP_FAILED) {
+      serr << "TextFileParser: Cannot map file " << file_name << " into memory." << endmsg;
+      close(file_descriptor_);
+      throw 1;
+    }
+    data_ = static_cast<const char*>(data);
+    madvise(data, size_, MADV_SEQUENTIAL);
+  }
+
+  // skip leading comments and read the header if the first line is not numeric
+  const char* last = data_+size_;
+  const char* line = data_;
+  while (line < last) {
+    const char* line_end = LineEnd(line, last);
+    if (!IsIgnoredLine(line, line_end)) {
+      const char* first     = SkipSeparators(line, line_end);
+      const char* field_end = first;
+      while (field_end < line_end && !IsSeparator(*field_end)) ++field_end;
+      std::string field(first, field_end);
+      char*       next      = NULL;
+      std::strtod(field.c_str(), &next);
+      if (next != field.c_str()+field.size()) {
+        for (const char* pos = first; pos < line_end; ) {
+          const char* field_end = pos;
+          while (field_end < line_end && !IsSeparator(*field_end)) ++field_end;
+          header_.push_back(std::string(pos, field_end));
+          pos = SkipSeparators(field_end, line_end);
+        }
+        line = line_end < last ? line_end+1 : last;
+      }
+      break;
+    }
+    line = line_end < last ? line_end+1 : last;
+  }
+  data_offset_ = line-data_;
+}
+
+doocore::io::TextFileParser::~TextFileParser() {
+  if (data_ != NULL) munmap(const_cast<char*>(data_), size_);
+  if (file_descriptor_ >= 0) close(file_descriptor_);
+}
+
+std::size_t doocore::io::TextFileParser::Parse(std::size_t num_columns, int num_threads,
+                                               std::vector<std::vector<double> >& columns) const {
+  const char* first = data_+data_offset_;
+  const char* last  = data_+size_;
+
+  // strtod needs a non-numeric character after the last number, so a final
+  // line without newline is parsed from a copy
+  std::string last_line;
+  if (first < last && *(last-1) != '\n') {
+    const char* last_line_begin = last;
+    while (last_line_begin > first && *(last_line_begin-1) != '\n') --last_line_begin;
+    last_line.assign(last_line_begin, last);
+    last = last_line_begin;
+  }
+
+  // split into chunks at line boundaries
+  std::size_t              num_chunks = std::max(1, num_threads);
+  std::vector<const char*> boundaries(1, first);
+  for (std::size_t i=1; i<num_chunks; ++i) {
+    const char* boundary = std::max(boundaries.back(), first+(last-first)*i/num_chunks);
+    if (boundary > first && boundary < last && *(boundary-1) != '\n') {
+      boundary = LineEnd(boundary, last);
+      if (boundary < last) ++boundary;
+    }
+    boundaries.push_back(boundary);
+  }
+  boundaries.push_back(last);
+
+  std::vector<std::vector<std::vector<double> > > chunk_columns(num_chunks, std::vector<std::vector<double> >(num_columns));
+  std::vector<std::size_t>                        chunk_bad_lines(num_chunks, 0);
+  if (num_chunks == 1) {
+    ParseChunk(first, last, num_columns, &chunk_columns[0], &chunk_bad_lines[0]);
+  } else {
+    boost::thread_group threads;
+    for (std::size_t i=0; i<num_chunks; ++i) {
+      threads.create_thread(boost::bind(&TextFileParser::ParseChunk, boundaries[i], boundaries[i+1],
+                                        num_columns, &chunk_columns[i], &chunk_bad_lines[i]));
+    }
+    threads.join_all();
+  }
+
+  std::size_t num_lines = 0;
+  num_bad_lines_        = 0;
+  for (std::size_t i=0; i<num_chunks; ++i) {
+    num_lines      += num_columns > 0 ? chunk_columns[i][0].size() : 0;
+    num_bad_lines_ += chunk_bad_lines[i];
+  }
+
+  columns.assign(num_columns, std::vector<double>());
+  for (std::size_t k=0; k<num_columns; ++k) {
+    columns[k].reserve(num_lines+1);
+    for (std::size_t i=0; i<num_chunks; ++i) {
+      columns[k].insert(columns[k].end(), chunk_columns[i][k].begin(), chunk_columns[i][k].end());
+      std::vector<double>().swap(chunk_columns[i][k]);
+    }
+  }
+
+  if (!last_line.empty()) {
+    std::size_t num_lines_before = columns.empty() ? 0 : columns[0].size();
+    std::vector<std::vector<double> > line_columns(num_columns);
+    ParseChunk(last_line.c_str(), last_line.c_str()+last_line.size(), num_columns, &line_columns, &num_bad_lines_);
+    for (std::size_t k=0; k<num_columns; ++k) {
+      columns[k].insert(columns[k].end(), line_columns[k].begin(), line_columns[k].end());
+    }
+    num_lines += (columns.empty() ? 0 : columns[0].size())-num_lines_before;
+  }
+
+  if (num_bad_lines_ > 0) {
+    swarn << "TextFileParser: Skipped " << num_bad_lines_ << " lines in " << file_name_
+          << " without exactly " << num_columns << " numeric fields." << endmsg;
+  }
+  return num_lines;
+}
+
+void doocore::io::TextFileParser::ParseChunk(const char* first, const char* last, std::size_t num_columns,
+                                             std::vector<std::vector<double> >* columns, std::size_t* num_bad_lines) {
+  std::vector<double> values(num_columns);
+  for (std::size_t k=0; k<num_columns; ++k) {
+    // rough guess of line count from average field width
+    (*columns)[k].reserve((last-first)/(num_columns*8+1));
+  }
+
+  for (const char* line = first; line < last; ) {
+    const char* line_end = LineEnd(line, last);
+    if (!IsIgnoredLine(line, line_end)) {
+      if (ParseLine(line, line_end, values)) {
+        for (std::size_t k=0; k<num_columns; ++k) {
+          (*columns)[k].push_back(values[k]);
+        }
+      } else {
+        ++(*num_bad_lines);
+      }
+    }
+    line = line_end+1;
+  }
+}
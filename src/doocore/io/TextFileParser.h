@@ -0,0 +1,141 @@
+#ifndef DOOCORE_IO_TEXTFILEPARSER_H
+#define DOOCORE_IO_TEXTFILEPARSER_H
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+
+namespace doocore {
+namespace io {
+
+/*! @class doocore::io::TextFileParser
+ * @brief Parallel parser for numeric text files with one entry per line
+ *
+ * TextFileParser reads whitespace- or comma-separated numeric columns from a
+ * text file. The file is memory mapped and split into chunks on newline
+ * boundaries, which are parsed by several threads and concatenated in file
+ * order afterwards. Numbers are converted with @c strtod directly on the
+ * mapped memory, so no stream extraction or line copies are involved.
+ *
+ * Empty lines and lines starting with @c # are skipped. If the first other
+ * line does not start with a number, it is taken as header with column
+ * names. Lines with a different number of fields than requested are skipped
+ * and counted.
+ *
+ * @section tfp_usage Usage
+ *
+ * TextFileParser is normally used via doocore::io::EasyTuple::FromTextFile():
+ *
+ * @code
+ * TextFileParser parser("calibration.txt");
+ * std::vector<std::vector<double> > columns;
+ * std::size_t num_lines = parser.Parse(parser.header().size(), 4, columns);
+ * @endcode
+ */
+class TextFileParser {
+ public:
+  /**
+   *  @brief Constructor for TextFileParser
+   *
+   *  Maps the file into memory. If the file cannot be opened or mapped, an
+   *  exception is thrown.
+   *
+   *  @param file_name name of the text file
+   */
+  TextFileParser(const std::string& file_name);
+
+  /**
+   *  @brief Destructor for TextFileParser
+   */
+  ~TextFileParser();
+
+  /**
+   *  @brief Parse all lines of the file into columns
+   *
+   *  @param num_columns number of fields expected per line
+   *  @param num_threads number of threads to parse with
+   *  @param columns column buffers to fill (replaced, one per field)
+   *  @return number of parsed lines
+   */
+  std::size_t Parse(std::size_t num_columns, int num_threads, std::vector<std::vector<double> >& columns) const;
+
+  /**
+   *  @brief Get column names from the header line
+   *
+   *  @return column names (empty if the file has no header)
+   */
+  const std::vector<std::string>& header() const { return header_; }
+
+  /**
+   *  @brief Get number of lines skipped in the last Parse() due to a wrong number of fields
+   *
+   *  @return number of skipped lines
+   */
+  std::size_t num_bad_lines() const { return num_bad_lines_; }
+
+ protected:
+
+ private:
+  /**
+   *  @brief Parse lines of a chunk of the file
+   *
+   *  @param first first character of the chunk (at a line start)
+   *  @param last end of the chunk (after a newline or at end of data)
+   *  @param num_columns number of fields expected per line
+   *  @param columns column buffers to append to
+   *  @param num_bad_lines counter for skipped lines
+   */
+  static void ParseChunk(const char* first, const char* last, std::size_t num_columns,
+                         std::vector<std::vector<double> >* columns, std::size_t* num_bad_lines);
+
+  /**
+   *  @brief Name of the file
+   */
+  std::string file_name_;
+
+  /**
+   *  @brief File descriptor
+   */
+  int file_descriptor_;
+
+  /**
+   *  @brief Mapped file content
+   */
+  const char* data_;
+
+  /**
+   *  @brief Size of the file
+   */
+  std::size_t size_;
+
+  /**
+   *  @brief Offset of the first data line (after comments and header)
+   */
+  std::size_t data_offset_;
+
+  /**
+   *  @brief Column names from header line
+   */
+  std::vector<std::string> header_;
+
+  /**
+   *  @brief Number of skipped lines in last Parse()
+   */
+  mutable std::size_t num_bad_lines_;
+}; // class TextFileParser
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_TEXTFILEPARSER_H
@@ -3,8 +3,15 @@
 // from STL
 #include <iostream>
 #include <fstream>
+#include <mutex>
 
 // from ROOT
+#include "RVersion.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+#include "TROOT.h"
+#else
+#include "TThread.h"
+#endif
 
 // from RooFit
 
@@ -103,6 +110,27 @@ std::string SecondsToTimeString(double seconds) {
   return ret;
 }
 
+void EnableRootThreadSafety() {
+  // may be called concurrently from several threads
+  static std::once_flag enabled;
+  std::call_once(enabled, []() {
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,6,0)
+    ROOT::EnableThreadSafety();
+#else
+    TThread::Initialize();
+#endif
+  });
+}
+
+unsigned long long HashString(const std::string& str) {
+  unsigned long long hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it) {
+    hash ^= static_cast<unsigned char>(*it);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
 } // namespace tools
 } // namespace io
 } // namespace doocore
@@ -37,6 +37,22 @@ void ReplaceScientificNotationInFile(std::string filename, bool debug_mode=false
 
 std::string SecondsToTimeString(double seconds);
 
+/**
+ *  @brief Enable ROOT's internal locking for multi-threaded usage
+ *
+ *  Has to be called before ROOT objects (like TFiles or TTrees) are used in
+ *  more than one thread. Calling it more than once is harmless.
+ */
+void EnableRootThreadSafety();
+
+/**
+ *  @brief 64 bit FNV-1a hash of a string
+ *
+ *  The hash is stable between runs and platforms and therefore suitable for
+ *  naming cache files.
+ */
+unsigned long long HashString(const std::string& str);
+
 } // namespace tools
 } // namespace io
 } // namespace doocore
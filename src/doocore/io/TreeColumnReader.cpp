@@ -0,0 +1,155 @@
+#include "doocore/io/TreeColumnReader.h"
+
+// from STL
+#include <string>
+#include <vector>
+
+// from ROOT
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TObjArray.h"
+#include "TTreeFormula.h"
+
+// from project
+#include "doocore/io/MsgStream.h"
+
+doocore::io::TreeColumnReader::TreeColumnReader(TTree& tree, const std::vector<std::string>& column_names, const std::string& selection)
+: tree_(tree),
+  column_names_(column_names),
+  types_(),
+  storage_(column_names.size(), 0),
+  branches_(column_names.size(), NULL),
+  selection_(NULL),
+  tree_number_(-1),
+  local_entry_(-1),
+  tree_first_entry_(0),
+  tree_last_entry_(0),
+  file_(NULL),
+  file_bytes_read_(0),
+  file_read_calls_(0),
+  bytes_read_(0),
+  read_calls_(0)
+{
+  for (std::vector<std::string>::const_iterator it = column_names_.begin(), end = column_names_.end();
+       it != end; ++it) {
+    types_.push_back(BranchColumnType(tree_, *it));
+  }
+
+  if (selection.length() > 0) {
+    selection_ = new TTreeFormula("doocore_selection", selection.c_str(), &tree_);
+    if (selection_->GetNdim() == 0) {
+      serr << "TreeColumnReader: Selection '" << selection << "' cannot be compiled." << endmsg;
+      delete selection_;
+      throw 6;
+    }
+  }
+
+  for (std::size_t i=0; i<column_names_.size(); ++i) {
+    tree_.SetBranchAddress(column_names_[i].c_str(), static_cast<void*>(&storage_[i]));
+  }
+}
+
+doocore::io::ColumnType doocore::io::TreeColumnReader::BranchColumnType(TTree& tree, const std::string& name) {
+  TBranch* branch = tree.GetBranch(name.c_str());
+  if (branch == NULL) {
+    serr << "TreeColumnReader: Branch " << name << " not in tree." << endmsg;
+    throw 6;
+  }
+
+  TObjArray* leaves = branch->GetListOfLeaves();
+  TLeaf*     leaf   = (leaves != NULL && leaves->GetEntries() == 1) ? dynamic_cast<TLeaf*>(leaves->At(0)) : NULL;
+  if (leaf == NULL || leaf->GetLen() != 1 || leaf->GetLeafCount() != NULL) {
+    serr << "TreeColumnReader: Branch " << name << " is not a scalar branch." << endmsg;
+    throw 6;
+  }
+
+  std::string type_name = leaf->GetTypeName();
+  if      (type_name == "Double_t")  return kColumnDouble;
+  else if (type_name == "Float_t")   return kColumnFloat;
+  else if (type_name == "Long64_t")  return kColumnLong64;
+  else if (type_name == "ULong64_t") return kColumnULong64;
+  else if (type_name == "Int_t")     return kColumnInt;
+  else if (type_name == "UInt_t")    return kColumnUInt;
+  else if (type_name == "Short_t")   return kColumnShort;
+  else if (type_name == "UShort_t")  return kColumnUShort;
+  else if (type_name == "Char_t")    return kColumnChar;
+  else if (type_name == "UChar_t")   return kColumnUChar;
+  else if (type_name == "Bool_t")    return kColumnBool;
+
+  serr << "TreeColumnReader: Branch " << name << " has unsupported type " << type_name << "." << endmsg;
+  throw 6;
+}
+
+doocore::io::TreeColumnReader::~TreeColumnReader() {
+  if (selection_ != NULL) delete selection_;
+  for (std::vector<std::string>::const_iterator it = column_names_.begin(), end = column_names_.end();
+       it != end; ++it) {
+    TBranch* branch = tree_.GetBranch(it->c_str());
+    if (branch != NULL) tree_.ResetBranchAddress(branch);
+  }
+}
+
+bool doocore::io::TreeColumnReader::LoadEntry(Long64_t entry) {
+  // a TChain closes the current file when switching to the next one
+  bool leaves_tree = entry < tree_first_entry_ || entry >= tree_last_entry_;
+  if (leaves_tree) CountFileReads();
+
+  local_entry_ = tree_.LoadTree(entry);
+  if (local_entry_ < 0) {
+    if (leaves_tree) file_ = NULL;
+    return false;
+  }
+
+  if (tree_number_ != tree_.GetTreeNumber()) UpdateBranches();
+  if (leaves_tree) {
+    tree_first_entry_ = entry-local_entry_;
+    tree_last_entry_  = tree_first_entry_+tree_.GetTree()->GetEntries();
+    if (file_ != tree_.GetCurrentFile()) {
+      file_            = tree_.GetCurrentFile();
+      file_bytes_read_ = file_ != NULL ? file_->GetBytesRead() : 0;
+      file_read_calls_ = file_ != NULL ? file_->GetReadCalls() : 0;
+    }
+  }
+
+  // getall=1 to read the branches even if deactivated in the tree
+  for (std::vector<TBranch*>::const_iterator it = branches_.begin(), end = branches_.end();
+       it != end; ++it) {
+    if ((*it)->GetEntry(local_entry_, 1) < 0) return false;
+  }
+  return true;
+}
+
+bool doocore::io::TreeColumnReader::PassesSelection() {
+  if (selection_ == NULL) return true;
+
+  // same semantics as TTree::Draw(): any instance passing accepts the entry
+  Int_t num_data = selection_->GetNdata();
+  for (Int_t i=0; i<num_data; ++i) {
+    if (selection_->EvalInstance(i) != 0) return true;
+  }
+  return false;
+}
+
+void doocore::io::TreeColumnReader::CountFileReads() {
+  if (file_ == NULL || file_ != tree_.GetCurrentFile()) return;
+  bytes_read_      += file_->GetBytesRead()-file_bytes_read_;
+  read_calls_      += file_->GetReadCalls()-file_read_calls_;
+  file_bytes_read_  = file_->GetBytesRead();
+  file_read_calls_  = file_->GetReadCalls();
+}
+
+void doocore::io::TreeColumnReader::UpdateBranches() {
+  TTree* current_tree = tree_.GetTree();
+  for (std::size_t i=0; i<column_names_.size(); ++i) {
+    branches_[i] = current_tree->GetBranch(column_names_[i].c_str());
+    if (branches_[i] == NULL) {
+      serr << "TreeColumnReader: Branch " << column_names_[i] << " not in tree number " << tree_.GetTreeNumber() << "." << endmsg;
+      throw 6;
+    }
+  }
+  if (selection_ != NULL) selection_->UpdateFormulaLeaves();
+  tree_number_ = tree_.GetTreeNumber();
+  if (tree_change_callback_) tree_change_callback_(tree_number_);
+}
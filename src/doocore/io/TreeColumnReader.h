@@ -0,0 +1,292 @@
+#ifndef DOOCORE_IO_TREECOLUMNREADER_H
+#define DOOCORE_IO_TREECOLUMNREADER_H
+
+// from STL
+#include <string>
+#include <vector>
+#include <cstring>
+#include <functional>
+
+// from ROOT
+#include "TTree.h"
+
+// from RooFit
+
+// from TMVA
+
+// from BOOST
+
+// from here
+
+// forward declarations
+class TFile;
+class TBranch;
+class TTreeFormula;
+
+namespace doocore {
+namespace io {
+
+/// Storage types of scalar branches supported by TreeColumnReader.
+enum ColumnType {
+  kColumnDouble,
+  kColumnFloat,
+  kColumnLong64,
+  kColumnULong64,
+  kColumnInt,
+  kColumnUInt,
+  kColumnShort,
+  kColumnUShort,
+  kColumnChar,
+  kColumnUChar,
+  kColumnBool
+};
+
+/*! @class doocore::io::TreeColumnReader
+ * @brief Native reader for scalar branches of a TTree or TChain
+ *
+ * TreeColumnReader binds a set of scalar branches to internal storage of the
+ * branches' own types and reads them entry by entry without any RooFit
+ * involvement. Only the requested branches are read (even if further branches
+ * are active), values can be retrieved either converted to double or in any
+ * other arithmetic type.
+ *
+ * Optionally, a selection string is evaluated as TTreeFormula for each entry.
+ *
+ * TreeColumnReader changes branch addresses of the supplied tree and resets
+ * them upon destruction. Only one reader should be used on a tree at a time.
+ *
+ * @section tcr_usage Usage
+ *
+ * @code
+ * std::vector<std::string> columns;
+ * columns.push_back("varMass");
+ * columns.push_back("catTag");
+ * TreeColumnReader reader(tree, columns, "varMass>5200");
+ * for (Long64_t i=0; i<tree.GetEntries(); ++i) {
+ *   if (reader.LoadEntry(i) && reader.PassesSelection()) {
+ *     double mass = reader.Value(0);
+ *     int tag     = reader.ValueAs<int>(1);
+ *   }
+ * }
+ * @endcode
+ */
+class TreeColumnReader {
+ public:
+  /**
+   *  @brief Constructor for TreeColumnReader
+   *
+   *  If one of the branches does not exist or is not a scalar branch of a
+   *  basic type, an exception is thrown.
+   *
+   *  @param tree TTree or TChain to read from
+   *  @param column_names names of the branches to read
+   *  @param selection optional selection to evaluate for each entry
+   */
+  TreeColumnReader(TTree& tree, const std::vector<std::string>& column_names, const std::string& selection="");
+
+  /**
+   *  @brief Destructor for TreeColumnReader
+   */
+  ~TreeColumnReader();
+
+  /**
+   *  @brief Load entry of all columns
+   *
+   *  @param entry entry number in tree (global entry number for TChains)
+   *  @return whether the entry could be loaded
+   */
+  bool LoadEntry(Long64_t entry);
+
+  /**
+   *  @brief Evaluate selection for currently loaded entry
+   *
+   *  @return whether the current entry passes the selection (true if no selection is set)
+   */
+  bool PassesSelection();
+
+  /**
+   *  @brief Get value of a column for the currently loaded entry
+   *
+   *  @param column index of the column as in constructor
+   *  @return value converted to double
+   */
+  double Value(std::size_t column) const { return ValueAs<double>(column); }
+
+  /**
+   *  @brief Get value of a column for the currently loaded entry in given type
+   *
+   *  @param column index of the column as in constructor
+   *  @return value converted to T
+   */
+  template<typename T>
+  T ValueAs(std::size_t column) const {
+    const Long64_t* slot = &storage_[column];
+    switch (types_[column]) {
+      case kColumnDouble:  return static_cast<T>(Get<Double_t>(slot));
+      case kColumnFloat:   return static_cast<T>(Get<Float_t>(slot));
+      case kColumnLong64:  return static_cast<T>(Get<Long64_t>(slot));
+      case kColumnULong64: return static_cast<T>(Get<ULong64_t>(slot));
+      case kColumnInt:     return static_cast<T>(Get<Int_t>(slot));
+      case kColumnUInt:    return static_cast<T>(Get<UInt_t>(slot));
+      case kColumnShort:   return static_cast<T>(Get<Short_t>(slot));
+      case kColumnUShort:  return static_cast<T>(Get<UShort_t>(slot));
+      case kColumnChar:    return static_cast<T>(Get<Char_t>(slot));
+      case kColumnUChar:   return static_cast<T>(Get<UChar_t>(slot));
+      case kColumnBool:    return static_cast<T>(Get<Bool_t>(slot));
+    }
+    return T();
+  }
+
+  /**
+   *  @brief Get storage type of a column
+   *
+   *  @param column index of the column as in constructor
+   *  @return storage type of the branch
+   */
+  ColumnType type(std::size_t column) const { return types_[column]; }
+
+  /**
+   *  @brief Get number of columns
+   *
+   *  @return number of columns
+   */
+  std::size_t num_columns() const { return column_names_.size(); }
+
+  /**
+   *  @brief Get names of columns
+   *
+   *  @return names of columns
+   */
+  const std::vector<std::string>& column_names() const { return column_names_; }
+
+  /**
+   *  @brief Determine storage type of a scalar branch
+   *
+   *  If the branch does not exist or is not a scalar branch of a basic type,
+   *  an exception is thrown.
+   *
+   *  @param tree TTree or TChain containing the branch
+   *  @param name name of the branch
+   *  @return storage type of the branch
+   */
+  static ColumnType BranchColumnType(TTree& tree, const std::string& name);
+
+  /**
+   *  @brief Set callback invoked whenever reading switches to another tree
+   *
+   *  For TChains, the callback receives the tree number in the chain each
+   *  time the reader switches to another file.
+   *
+   *  @param callback function to call with the new tree number
+   */
+  void set_tree_change_callback(const std::function<void(int)>& callback) { tree_change_callback_ = callback; }
+
+  /**
+   *  @brief Get number of bytes read from the tree's files by this reader
+   *
+   *  Only reads of the files' own counters since the first entry loaded by 
+   *  this reader are taken into account, so that reads of other trees in 
+   *  other threads are excluded. For TChains, reads of all files are added.
+   *
+   *  @return number of bytes read
+   */
+  Long64_t bytes_read() { CountFileReads(); return bytes_read_; }
+
+  /**
+   *  @brief Get number of read calls on the tree's files by this reader
+   *
+   *  @return number of read calls (see bytes_read())
+   */
+  Long64_t read_calls() { CountFileReads(); return read_calls_; }
+
+ protected:
+
+ private:
+  /**
+   *  @brief Read value of type T from storage slot
+   */
+  template<typename T>
+  static T Get(const Long64_t* slot) {
+    T value;
+    std::memcpy(&value, slot, sizeof(T));
+    return value;
+  }
+
+  /**
+   *  @brief Update branch pointers and formula after switching tree in TChain
+   */
+  void UpdateBranches();
+
+  /**
+   *  @brief Add reads of the current file since the last call to the counters
+   */
+  void CountFileReads();
+
+  /**
+   *  @brief Tree to read from
+   */
+  TTree& tree_;
+
+  /**
+   *  @brief Names of columns
+   */
+  std::vector<std::string> column_names_;
+
+  /**
+   *  @brief Storage types of columns
+   */
+  std::vector<ColumnType> types_;
+
+  /**
+   *  @brief Storage for branch values (one 8 byte slot per column)
+   */
+  std::vector<Long64_t> storage_;
+
+  /**
+   *  @brief Branches of current tree
+   */
+  std::vector<TBranch*> branches_;
+
+  /**
+   *  @brief Selection formula (NULL if no selection)
+   */
+  TTreeFormula* selection_;
+
+  /**
+   *  @brief Tree number in TChain the branch pointers are valid for
+   */
+  Int_t tree_number_;
+
+  /**
+   *  @brief Local entry number in current tree
+   */
+  Long64_t local_entry_;
+
+  /**
+   *  @brief Range of global entry numbers of the current tree
+   */
+  Long64_t tree_first_entry_;
+  Long64_t tree_last_entry_;
+
+  /**
+   *  @brief File the read counters are taken from and its counters at the last count
+   */
+  TFile*   file_;
+  Long64_t file_bytes_read_;
+  Long64_t file_read_calls_;
+
+  /**
+   *  @brief Bytes read and read calls counted so far
+   */
+  Long64_t bytes_read_;
+  Long64_t read_calls_;
+
+  /**
+   *  @brief Callback on switching tree (may be empty)
+   */
+  std::function<void(int)> tree_change_callback_;
+}; // class TreeColumnReader
+} // namespace io
+} // namespace doocore
+
+#endif // DOOCORE_IO_TREECOLUMNREADER_H
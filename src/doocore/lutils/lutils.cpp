@@ -43,6 +43,7 @@
 
 // from project
 #include "doocore/io/MsgStream.h"
+#include "doocore/io/HistogramFiller.h"
 
 using namespace std;
 using namespace doocore::io;
@@ -1772,27 +1773,27 @@ std::pair<double,double> doocore::lutils::MedianLimitsForTuple(const RooDataSet&
   
   
   if (debug) {
-    sdebug << "num_entries = " << num_entries << endmsg;
-    sdebug << "entries.size() = " << entries.size() << endmsg;
+    DOOCORE_DEBUG << "num_entries = " << num_entries << endmsg;
+    DOOCORE_DEBUG << "entries.size() = " << entries.size() << endmsg;
   }
   
   if (!entries.empty()) {
     if (debug) {
-      sdebug << "doocore::lutils::MedianLimitsForTuple(...) range: " << entries.front() << " - " << entries.back() << endmsg;
-      sdebug << "idx_median = " << idx_median << ", entries[idx_median] = " << entries[idx_median] << endmsg;
-      sdebug << "(int)(idx_median*0.32) = " << (int)(idx_median*0.32) << endmsg;
-      sdebug << "(int)(entries.size()-idx_median*0.32) = " << (int)(entries.size()-idx_median*0.32) << endmsg;
-      sdebug << "-4*entries[idx_median] = " << -4*entries[idx_median] << endmsg;
-      sdebug << "5*entries[(int)(idx_median*0.32)] = " << 5*entries[(int)(idx_median*0.32)] << endmsg;
-      sdebug << "5*entries[(int)(entries.size()-idx_median*0.32)] = " << 5*entries[(int)(entries.size()-idx_median*0.32)] << endmsg;
-      sdebug << "first: " << minmax.first << endmsg;
-      sdebug << "second: " << minmax.second << endmsg;
+      DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) range: " << entries.front() << " - " << entries.back() << endmsg;
+      DOOCORE_DEBUG << "idx_median = " << idx_median << ", entries[idx_median] = " << entries[idx_median] << endmsg;
+      DOOCORE_DEBUG << "(int)(idx_median*0.32) = " << (int)(idx_median*0.32) << endmsg;
+      DOOCORE_DEBUG << "(int)(entries.size()-idx_median*0.32) = " << (int)(entries.size()-idx_median*0.32) << endmsg;
+      DOOCORE_DEBUG << "-4*entries[idx_median] = " << -4*entries[idx_median] << endmsg;
+      DOOCORE_DEBUG << "5*entries[(int)(idx_median*0.32)] = " << 5*entries[(int)(idx_median*0.32)] << endmsg;
+      DOOCORE_DEBUG << "5*entries[(int)(entries.size()-idx_median*0.32)] = " << 5*entries[(int)(entries.size()-idx_median*0.32)] << endmsg;
+      DOOCORE_DEBUG << "first: " << minmax.first << endmsg;
+      DOOCORE_DEBUG << "second: " << minmax.second << endmsg;
     }
 
     minmax.first  = -4*entries[idx_median]+5*entries[(int)(idx_median*0.32)];
     minmax.second = -4*entries[idx_median]+5*entries[(int)(entries.size()-idx_median*0.32)];
 
-    if (debug) sdebug << "doocore::lutils::MedianLimitsForTuple(...) after quantiles: " << minmax.first << " - " << minmax.second << endmsg;
+    if (debug) DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) after quantiles: " << minmax.first << " - " << minmax.second << endmsg;
   
     // if computed range is larger than min/max value choose those
     if (minmax.first < entries.front()){
@@ -1802,14 +1803,14 @@ std::pair<double,double> doocore::lutils::MedianLimitsForTuple(const RooDataSet&
       minmax.second = entries.back();
     }
     
-    if (debug) sdebug << "doocore::lutils::MedianLimitsForTuple(...) after overflow check: " << minmax.first << " - " << minmax.second << endmsg;
+    if (debug) DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) after overflow check: " << minmax.first << " - " << minmax.second << endmsg;
 
     if (minmax.first >= minmax.second) {
       minmax.first  = entries[idx_median]*(minmax.first  > 0 ? 0.98 : 1.02);
       minmax.second = entries[idx_median]*(minmax.second > 0 ? 1.02 : 0.98);
     }
     
-    if (debug) sdebug << "doocore::lutils::MedianLimitsForTuple(...) after flip/equality check: " << minmax.first << " - " << minmax.second << endmsg;
+    if (debug) DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) after flip/equality check: " << minmax.first << " - " << minmax.second << endmsg;
     
     // if everything fails, just take all
     if (minmax.first == 0 && minmax.second == 0) {
@@ -1817,7 +1818,7 @@ std::pair<double,double> doocore::lutils::MedianLimitsForTuple(const RooDataSet&
       minmax.second = entries[num_entries-1]+0.1*(entries[entries.size()-1]-entries[0]);
     }
     
-    if (debug) sdebug << "doocore::lutils::MedianLimitsForTuple(...) after zero check: " << minmax.first << " - " << minmax.second << endmsg;
+    if (debug) DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) after zero check: " << minmax.first << " - " << minmax.second << endmsg;
   } else {
     minmax.first  = -1;
     minmax.second = +1;
@@ -1917,10 +1918,13 @@ void doocore::lutils::plotAsymmetry(TString pPlotName, TTree * pTuple, TString p
 
         //get histograms for time distributions of (non)oszilated B0 candidates from datafile
         TH1D * hUpOsz = new TH1D("hUpOs",TString("MagUp oszilated;time (ns);nr. of candidates/")+Form("%f",(rngMax-rngMin)/(double)nBins) + pTimeUnit,nBins,rngMin,rngMax);
-        tree->Draw(pVarTime + ">>hUpOs",        "(" + pVarTime + " > -1) & (" + pVarMix + " == -1)");
-
         TH1D * hUpNos = new TH1D("hUpNo",TString("MagUp non oszilated;time (ns);nr. of candidates/")+Form("%f",(rngMax-rngMin)/(double)nBins) + pTimeUnit,nBins,rngMin,rngMax);
-        tree->Draw(pVarTime + ">>hUpNo",        "(" + pVarTime + " > -1) & (" + pVarMix + " == 1)");
+
+        //fill both histograms in one pass over the tree
+        doocore::io::HistogramFiller filler(*tree);
+        filler.Add(*hUpOsz, pVarTime.Data(), ("(" + pVarTime + " > -1) & (" + pVarMix + " == -1)").Data());
+        filler.Add(*hUpNos, pVarTime.Data(), ("(" + pVarTime + " > -1) & (" + pVarMix + " == 1)").Data());
+        filler.Fill();
 
         //build histograms with N_notoszilated +/- N_oszilated
         TH1D * hUpSum = (TH1D*)hUpNos->Clone("hUpSum");
@@ -2000,7 +2004,7 @@ std::pair<double,double> doocore::lutils::MinMaxLimitsForDataSet(const RooDataSe
     // if (debug) sdebug << entries[i] << endmsg;
   // }
 
-  if (debug) sdebug << "doocore::lutils::MedianLimitsForTuple(...) range: " << entries.front() << " - " << entries.back() << endmsg;
+  if (debug) DOOCORE_DEBUG << "doocore::lutils::MedianLimitsForTuple(...) range: " << entries.front() << " - " << entries.back() << endmsg;
 
   minmax.first = entries.front();
   minmax.second = entries.back();